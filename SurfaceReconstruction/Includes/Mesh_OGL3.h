@@ -25,6 +25,13 @@ public:
 	void addIndex(unsigned int index) {
 		indices.push_back(index);
 	}
+	void setGeometry(std::vector<Vertex> newVertices, std::vector<unsigned int> newIndices) {
+		vertices = std::move(newVertices);
+		indices = std::move(newIndices);
+	}
+
+	const std::vector<Vertex>& getVertices() const { return vertices; }
+	const std::vector<unsigned int>& getIndices() const { return indices; }
 private:
 	GLuint vertexArrayObject;
 	GLuint vertexBuffer;
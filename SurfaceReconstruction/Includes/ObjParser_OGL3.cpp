@@ -1,10 +1,234 @@
 #include "ObjParser_OGL3.h"
 
 #include <string>
+#include <charconv>
+#include <climits>
+#include <iostream>
+#include "../mapped_file.h"
 
 using namespace std;
 
+namespace
+{
+	// open addressing (linear probing) map from a v/vt/vn triplet to its vertex index
+	class VertexHashTable
+	{
+	public:
+		VertexHashTable() : slots(1024), count(0) {}
+
+		// returns the index stored for the key, or stores newIndex and returns it
+		unsigned int findOrInsert(int v, int vt, int vn, unsigned int newIndex)
+		{
+			if (2 * (count + 1) > slots.size())
+				grow();
+
+			size_t i = hash(v, vt, vn) & (slots.size() - 1);
+			while (slots[i].index != UINT_MAX)
+			{
+				if (slots[i].v == v && slots[i].vt == vt && slots[i].vn == vn)
+					return slots[i].index;
+				i = (i + 1) & (slots.size() - 1);
+			}
+			slots[i] = Slot{ v, vt, vn, newIndex };
+			++count;
+			return newIndex;
+		}
+
+	private:
+		struct Slot {
+			int v = 0, vt = 0, vn = 0;
+			unsigned int index = UINT_MAX;
+		};
+
+		static size_t hash(int v, int vt, int vn)
+		{
+			uint64_t h = (uint32_t)v * 0x9E3779B97F4A7C15ull;
+			h ^= ((uint64_t)(uint32_t)vt << 21) ^ ((uint64_t)(uint32_t)vn << 42);
+			h *= 0xBF58476D1CE4E5B9ull;
+			return (size_t)(h ^ (h >> 31));
+		}
+
+		void grow()
+		{
+			std::vector<Slot> old(slots.size() * 2);
+			old.swap(slots);
+			count = 0;
+			for (const Slot& slot : old)
+				if (slot.index != UINT_MAX)
+					findOrInsert(slot.v, slot.vt, slot.vn, slot.index);
+		}
+
+		std::vector<Slot> slots;
+		size_t count;
+	};
+
+	inline const char* skipSpaces(const char* it, const char* end)
+	{
+		while (it < end && (*it == ' ' || *it == '\t' || *it == '\r'))
+			++it;
+		return it;
+	}
+
+	inline const char* skipToNextLine(const char* it, const char* end)
+	{
+		while (it < end && *it != '\n')
+			++it;
+		return it < end ? it + 1 : end;
+	}
+
+	// unparsable values (e.g. -1.#IND00 normals) read as 0 like in the stream parser
+	inline const char* parseFloat(const char* it, const char* end, float& value)
+	{
+		it = skipSpaces(it, end);
+		if (it < end && *it == '+')
+			++it;
+		const auto result = std::from_chars(it, end, value);
+		if (result.ec != std::errc())
+		{
+			value = 0.0f;
+			while (it < end && *it != ' ' && *it != '\t' && *it != '\r' && *it != '\n')
+				++it;
+			return it;
+		}
+		return result.ptr;
+	}
+
+	// converts a 1 based (or negative, relative) obj index to 0 based, -1 if it is missing or out of range
+	inline int resolveIndex(int index, size_t count)
+	{
+		if (index > 0 && (size_t)index <= count)
+			return index - 1;
+		if (index < 0 && (size_t)-index <= count)
+			return (int)count + index;
+		return -1;
+	}
+}
+
 Mesh* ObjParser::parse(const char* fileName)
+{
+	const mapped_file file(fileName);
+	if (!file.is_open())
+		throw(EXC_FILENOTFOUND);
+
+	std::vector<Mesh::Vertex> vertices;
+	std::vector<unsigned int> indices;
+	if (!parseData(file.begin(), file.end(), vertices, indices))
+		throw(EXC_INVALIDINDEX);
+
+	Mesh* mesh = new Mesh();
+	mesh->setGeometry(std::move(vertices), std::move(indices));
+	return mesh;
+}
+
+bool ObjParser::parseData(const char* begin, const char* end, std::vector<Mesh::Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texcoords;
+	std::vector<unsigned int> polygon;
+	VertexHashTable vertexIndices;
+
+	vertices.clear();
+	indices.clear();
+
+	const char* it = begin;
+	while (it < end)
+	{
+		it = skipSpaces(it, end);
+		if (it + 1 >= end)
+			break;
+
+		if (it[0] == 'v' && (it[1] == ' ' || it[1] == '\t'))
+		{
+			glm::vec3 position;
+			it = parseFloat(it + 1, end, position.x);
+			it = parseFloat(it, end, position.y);
+			it = parseFloat(it, end, position.z);
+			positions.push_back(position);
+		}
+		else if (it[0] == 'v' && it[1] == 't')
+		{
+			glm::vec2 texcoord;
+			it = parseFloat(it + 2, end, texcoord.x);
+			it = parseFloat(it, end, texcoord.y);
+			texcoords.push_back(texcoord);
+		}
+		else if (it[0] == 'v' && it[1] == 'n')
+		{
+			glm::vec3 normal;
+			it = parseFloat(it + 2, end, normal.x);
+			it = parseFloat(it, end, normal.y);
+			it = parseFloat(it, end, normal.z);
+			normals.push_back(normal);
+		}
+		else if (it[0] == 'f' && (it[1] == ' ' || it[1] == '\t'))
+		{
+			polygon.clear();
+			it = skipSpaces(it + 1, end);
+			while (it < end && *it != '\n' && *it != '#')
+			{
+				int v = 0, vt = 0, vn = 0;
+				auto result = std::from_chars(it, end, v);
+				if (result.ec != std::errc())
+				{
+					std::cerr << "Invalid obj face at byte " << (it - begin) << std::endl;
+					return false;
+				}
+				it = result.ptr;
+				if (it < end && *it == '/')
+				{
+					++it;
+					if (it < end && *it != '/')
+					{
+						result = std::from_chars(it, end, vt);
+						it = result.ptr;
+					}
+					if (it < end && *it == '/')
+					{
+						result = std::from_chars(it + 1, end, vn);
+						it = result.ptr;
+					}
+				}
+
+				const int iPosition = resolveIndex(v, positions.size());
+				const int iTexCoord = vt != 0 ? resolveIndex(vt, texcoords.size()) : -1;
+				const int iNormal = vn != 0 ? resolveIndex(vn, normals.size()) : -1;
+				if (iPosition < 0 || (vt != 0 && iTexCoord < 0) || (vn != 0 && iNormal < 0))
+				{
+					std::cerr << "Obj face index out of range at byte " << (it - begin) << std::endl;
+					return false;
+				}
+
+				const unsigned int newIndex = (unsigned int)vertices.size();
+				const unsigned int index = vertexIndices.findOrInsert(iPosition, iTexCoord, iNormal, newIndex);
+				if (index == newIndex)
+				{
+					Mesh::Vertex vertex{};
+					vertex.position = positions[iPosition];
+					if (iTexCoord >= 0)
+						vertex.texcoord = texcoords[iTexCoord];
+					if (iNormal >= 0)
+						vertex.normal = normals[iNormal];
+					vertices.push_back(vertex);
+				}
+				polygon.push_back(index);
+				it = skipSpaces(it, end);
+			}
+
+			// triangle fan around the first corner
+			for (size_t i = 2; i < polygon.size(); ++i)
+			{
+				indices.push_back(polygon[0]);
+				indices.push_back(polygon[i - 1]);
+				indices.push_back(polygon[i]);
+			}
+		}
+		it = skipToNextLine(it, end);
+	}
+	return true;
+}
+
+Mesh* ObjParser::parseStream(const char* fileName)
 {
 	ObjParser theParser;
 
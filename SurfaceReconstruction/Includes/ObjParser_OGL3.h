@@ -12,9 +12,14 @@
 class ObjParser
 {
 public:
+	// memory mapped parser, polygons with more than 3 vertices are triangulated as fans
 	static Mesh* parse(const char* fileName);
+	// the original ifstream based parser, kept to benchmark against
+	static Mesh* parseStream(const char* fileName);
+	// parses the contents of an obj file into deduplicated vertices and triangle indices, returns false on invalid indices
+	static bool parseData(const char* begin, const char* end, std::vector<Mesh::Vertex>& vertices, std::vector<unsigned int>& indices);
 
-	enum Exception { EXC_FILENOTFOUND };
+	enum Exception { EXC_FILENOTFOUND, EXC_INVALIDINDEX };
 private:
 	struct IndexedVert {
 		int v, vt, vn;
@@ -35,12 +35,15 @@ public:
 
 	void AttachFromFile(const std::string&, bool generateMipMap = true, GLuint role = static_cast<GLuint>(type));
 	void FromFile(const std::string&);
+	void FromMemory(int width, int height, int channels, const void* pixels, bool generateMipMap = true);
 
 	operator unsigned int() const { return m_id; }
 
 	void Clean();
 
 private:
+	void Upload(int width, int height, GLenum sourceFormat, const void* pixels, bool generateMipMap, GLuint role);
+
 	GLuint m_id{};
 };
 
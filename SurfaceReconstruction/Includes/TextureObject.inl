@@ -129,17 +129,25 @@ inline void TextureObject<type>::AttachFromFile(const std::string& filename, boo
     }
 
 
+    Upload(loaded_img->w, loaded_img->h, source_format, loaded_img->pixels, generateMipMap, role);
+
+    SDL_FreeSurface(loaded_img);
+}
+
+template <TextureType type>
+inline void TextureObject<type>::Upload(int width, int height, GLenum sourceFormat, const void* pixels, bool generateMipMap, GLuint role)
+{
     glBindTexture(static_cast<GLenum>(type), m_id);
     glTexImage2D(
         role, // melyik binding point-on van a textúra erőforrás, amihez tárolást rendelünk
         0, // melyik részletességi szint adatait határozzuk meg
         GL_RGBA, // textúra belső tárolási formátuma (GPU-n)
-        loaded_img->w, // szélesség
-        loaded_img->h, // magasság
+        width, // szélesség
+        height, // magasság
         0, // nulla kell, hogy legyen ( https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glTexImage2D.xhtml )
-        source_format, // forrás (=CPU-n) formátuma
+        sourceFormat, // forrás (=CPU-n) formátuma
         GL_UNSIGNED_BYTE, // forrás egy pixelének egy csatornáját hogyan tároljuk
-        loaded_img->pixels); // forráshoz pointer
+        pixels); // forráshoz pointer
 
     if (generateMipMap)
         glGenerateMipmap(static_cast<GLenum>(type));
@@ -148,8 +156,15 @@ inline void TextureObject<type>::AttachFromFile(const std::string& filename, boo
     glTexParameteri(static_cast<GLenum>(type), GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(static_cast<GLenum>(type), GL_TEXTURE_WRAP_S, GL_CLAMP);
     glTexParameteri(static_cast<GLenum>(type), GL_TEXTURE_WRAP_T, GL_CLAMP);
+}
 
-    SDL_FreeSurface(loaded_img);
+template <TextureType type>
+inline void TextureObject<type>::FromMemory(int width, int height, int channels, const void* pixels, bool generateMipMap)
+{
+    // rows of tightly packed RGB images are not necessarily 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    Upload(width, height, channels == 3 ? GL_RGB : GL_RGBA, pixels, generateMipMap, static_cast<GLuint>(type));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
 template <TextureType type>
@@ -1,13 +1,22 @@
 ﻿#include <math.h>
 #include <vector>
-#include <stack>
 #include <random>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
 #include <glm/glm.hpp>
 #include "application.h"
 #include <glm/gtc/type_ptr.hpp>
 #include "delaunay_3d.h"
 #include "imgui/imgui.h"
 #include "file_loader.h"
+#include "frame_cache.h"
+#include "frame_archive.h"
+#include "camera_colorizer.h"
+#include "obj_parser_benchmark.h"
 
 application::application(void) {
     m_start_eye = glm::vec3(0, 0, 0);
@@ -33,11 +42,24 @@ application::application(void) {
     m_show_non_shaded_points = false;
     m_show_non_shaded_mesh = false;
     m_auto_increment_rendered_point_index = false;
+    m_use_frame_cache = true;
+
+    m_sequence_frames_per_second = 10.0f;
+    m_sequence_prefetch_count = 3;
+    m_sequence_frame_number = -1;
+    m_sequence_frame_index = 0;
+    m_live_port = velodyne_packet_decoder::data_port;
+    m_live_frame_index = 0;
+    m_dataset_frame_number = 0;
+    m_mesh_export_format = 0;
+    m_colormap_palette = colormap::rainbow;
+    m_colormap_max_intensity = 255;
+    m_has_source_colors = false;
 
     m_mesh_rendering_mode = none;
     m_octree_color = glm::vec3(0, 1.f, 0);
     m_delaunay = delaunay_3d(200.0f, glm::vec3(0.0f, 0.0f, 120.0f));
-    m_sensor_rig_boundary = octree::boundary{glm::vec3(-2.3f, -1.7f, -0.5), glm::vec3(1.7f, 0.4f, 0.7f)};
+    m_sensor_rig_boundary = dataset_manifest::get_default_rig_boundary();
 }
 
 bool application::init(SDL_Window* window) {
@@ -48,7 +70,7 @@ bool application::init(SDL_Window* window) {
     glEnable(GL_DEPTH_TEST);
 
     m_axes_program.Init({{GL_VERTEX_SHADER, "shaders/axes.vert"}, {GL_FRAGMENT_SHADER, "shaders/axes.frag"}});
-    m_particle_program.Init({{GL_VERTEX_SHADER, "shaders/particle.vert"}, {GL_FRAGMENT_SHADER, "shaders/particle.frag"}}, {{0, "vs_in_pos"}, {1, "vs_in_col"}, {2, "vs_in_tex"}});
+    m_particle_program.Init({{GL_VERTEX_SHADER, "shaders/particle.vert"}, {GL_FRAGMENT_SHADER, "shaders/particle.frag"}}, {{0, "vs_in_x"}, {1, "vs_in_col"}, {2, "vs_in_tex"}, {3, "vs_in_y"}, {4, "vs_in_z"}});
     m_wireframe_program.Init({{GL_VERTEX_SHADER, "shaders/wireframe.vert"}, {GL_FRAGMENT_SHADER, "shaders/wireframe.frag"}}, {{0, "vs_in_pos"}, {1, "vs_in_col"},});
 
     load_inputs_from_folder("inputs\\garazs_kijarat");
@@ -59,7 +81,10 @@ bool application::init(SDL_Window* window) {
     return true;
 }
 
-void application::clean() {}
+void application::clean() {
+    m_sequence_player.stop();
+    m_live_receiver.stop();
+}
 
 void application::reset() {}
 
@@ -77,9 +102,25 @@ void application::update() {
     m_virtual_camera.Update(delta_time);
     last_time = SDL_GetTicks();
 
-    if (m_auto_increment_rendered_point_index && m_render_points_up_to_index < m_vertices.size()) {
+    if (m_auto_increment_rendered_point_index && m_render_points_up_to_index < get_max_render_point_index()) {
         m_render_points_up_to_index += 1;
     }
+
+    if (m_sequence_player.is_playing()) {
+        frame_sequence_player::frame frame;
+        if (m_sequence_player.poll(frame)) {
+            m_sequence_frame_number = frame.frame_number;
+            m_sequence_frame_index = frame.index;
+            apply_frame(std::move(frame.points), frame.images);
+        }
+    }
+
+    // only the newest revolution is shown, the receiver keeps decoding while the frame is being processed
+    if (m_live_receiver.is_running() && m_live_receiver.poll_latest(m_live_frame)) {
+        m_live_frame_index = m_live_frame.index;
+        // the points are copied into the point cloud, the frame buffer goes back to the receiver on the next poll
+        apply_frame(m_live_frame.vertices, {});
+    }
 }
 
 void application::render() {
@@ -145,64 +186,215 @@ void application::resize(int _w, int _h) {
 }
 
 void application::load_inputs_from_folder(const std::string& folder_name) {
-    const std::vector<std::string> file_paths = file_loader::get_directory_files(folder_name);
-    std::string xyz_file;
-
-    for (const auto& file : file_paths) {
-        if (file.find("Dev0") != std::string::npos) {
-            m_digital_camera_textures[0].FromFile(file);
-            std::cout << "Loaded texture from " << file << std::endl;
-        } else if (file.find("Dev1") != std::string::npos) {
-            m_digital_camera_textures[1].FromFile(file);
-            std::cout << "Loaded texture from " << file << std::endl;
-        } else if (file.find("Dev2") != std::string::npos) {
-            m_digital_camera_textures[2].FromFile(file);
-            std::cout << "Loaded texture from " << file << std::endl;
-        } else if (file.find(".xyz") != std::string::npos) {
-            xyz_file = file;
+    m_sequence_player.stop();
+    m_live_receiver.stop();
+
+    if (!open_dataset(folder_name) || m_dataset.get_frames().empty()) {
+        std::cerr << "No frames found in " << folder_name << std::endl;
+        return;
+    }
+    m_dataset_frame_number = m_dataset.get_frames().front().frame_number;
+    load_dataset_frame(m_dataset_frame_number);
+}
+
+bool application::open_dataset(const std::string& folder_name) {
+    m_dataset_folder = folder_name;
+    m_dataset_manifest_path = dataset_manifest::get_manifest_path(folder_name);
+    std::error_code error;
+    if (std::filesystem::exists(m_dataset_manifest_path, error)) {
+        if (!m_dataset.load(m_dataset_manifest_path)) {
+            return false;
         }
+    } else {
+        // folders without a manifest are scanned once and get one written for the next time
+        const std::string camera_params_file = "inputs\\CameraParameters.json";
+        m_dataset = dataset_manifest();
+        m_dataset.camera_params = file_loader::load_digital_camera_params_json(camera_params_file);
+        std::cout << "Loaded digital camera parameters from " << camera_params_file << std::endl;
+        m_dataset.rig_boundary = m_sensor_rig_boundary;
+        m_dataset.set_frames(dataset_manifest::scan_folder(folder_name));
+        if (m_dataset.save(m_dataset_manifest_path)) {
+            std::cout << "Wrote dataset manifest " << m_dataset_manifest_path << std::endl;
+        }
+    }
+
+    m_sensor_rig_boundary = m_dataset.rig_boundary;
+    return true;
+}
+
+void application::load_dataset_frame(const int frame_number) {
+    const dataset_manifest::frame_entry* entry = m_dataset.find_frame(frame_number);
+    if (entry == nullptr) {
+        std::cerr << "Frame fn" << frame_number << " is not in " << m_dataset_manifest_path << std::endl;
+        return;
     }
 
-    m_vertices = file_loader::load_xyz_file(xyz_file);
-    std::cout << "Loaded " << m_vertices.size() << " points from " << xyz_file << std::endl;
-    m_render_points_up_to_index = m_vertices.size() - 16;
-    m_digital_camera_params = file_loader::load_digital_camera_params("inputs\\CameraParametersMinimal.txt");
-    std::cout << "Loaded digital camera parameters from inputs\\CameraParametersMinimal.txt" << std::endl;
+    const std::vector<std::string> sources = {entry->points.file, entry->images[0].file, entry->images[1].file, entry->images[2].file, m_dataset_manifest_path};
+    const std::string cache_path = frame_cache::get_cache_path(m_dataset_folder, frame_number);
+    frame_cache::frame frame;
+    if (m_use_frame_cache && frame_cache::load(cache_path, sources, frame)) {
+        std::cout << "Loaded cached frame from " << cache_path << std::endl;
+    } else {
+        // the jpegs are decoded on worker threads while the points are parsed, only the gl upload in apply_frame
+        // has to happen on this thread, so a frame takes about max(decode, parse) instead of their sum
+        const auto load_start = std::chrono::steady_clock::now();
+        frame.images.resize(3);
+        std::future<bool> image_decodes[3];
+        for (int i = 0; i < 3; ++i) {
+            image_decodes[i] = std::async(std::launch::async, dataset_manifest::load_image, std::cref(entry->images[i]), std::ref(frame.images[i]));
+        }
+        const bool is_whole_xyz_file = entry->points.offset == 0 && entry->points.size == 0 && !frame_archive::is_archive_file(entry->points.file);
+        frame.vertices = is_whole_xyz_file
+                             ? file_loader::load_xyz_file_parallel(entry->points.file, 0, &m_last_load_statistics)
+                             : dataset_manifest::load_points(entry->points);
+        frame.camera_params = m_dataset.camera_params;
+        for (int i = 0; i < 3; ++i) {
+            if (image_decodes[i].get()) {
+                std::cout << "Loaded texture from " << entry->images[i].file << std::endl;
+            }
+        }
+        const auto load_end = std::chrono::steady_clock::now();
+        std::cout << "Decoded images and points in " << std::chrono::duration<double, std::milli>(load_end - load_start).count() << " ms" << std::endl;
+        if (m_use_frame_cache && frame_cache::save(cache_path, sources, frame)) {
+            std::cout << "Saved frame cache to " << cache_path << std::endl;
+        }
+    }
 
+    m_xyz_file = entry->points.file;
+    m_digital_camera_params = std::move(frame.camera_params);
+    std::cout << "Loaded " << frame.vertices.size() << " points of frame fn" << frame_number << " from " << entry->points.file << std::endl;
+    apply_frame(frame.vertices, frame.images);
+}
+
+void application::apply_frame(const std::vector<file_loader::vertex>& vertices, const std::vector<file_loader::image>& images, const bool has_colors) {
+    // without colors of the source only the intensities are kept, the colors of the points and the mesh come from the colormap
+    apply_frame(point_cloud::from_vertices(vertices, has_colors), images, has_colors);
+}
+
+void application::apply_frame(point_cloud&& points, const std::vector<file_loader::image>& images, const bool has_colors) {
+    // a cpu copy of what the textures hold, exports are colored from it
+    m_digital_camera_images.resize(3);
+    for (int i = 0; i < 3 && i < (int)images.size(); ++i) {
+        const file_loader::image& image = images[i];
+        if (!image.pixels.empty()) {
+            m_digital_camera_textures[i].FromMemory(image.width, image.height, image.channels, image.pixels.data());
+            m_digital_camera_images[i] = image;
+        }
+    }
+
+    m_has_source_colors = has_colors;
+    m_points = std::move(points);
+    m_render_points_up_to_index = get_max_render_point_index();
+
+    apply_colormap();
     init_point_visualization();
-    randomize_vertex_colors(m_vertices);
-    init_octree(m_vertices);
-    init_octree_visualization(&m_octree);
+    init_octree(m_points);
+    init_octree_visualization(m_octree);
     init_delaunay_shaded_points_segment();
     init_mesh_visualization();
 }
 
+void application::export_mesh() {
+    static const char* extensions[] = {".ply", ".obj", ".glb", ".gltf"};
+    std::string mesh_file = m_input_folder;
+    while (!mesh_file.empty() && (mesh_file.back() == '\\' || mesh_file.back() == '/')) {
+        mesh_file.pop_back();
+    }
+    mesh_file += std::string("_mesh") + extensions[m_mesh_export_format];
+
+    // the mesh shows the camera colors where a camera sees the points, the export does the same
+    std::vector<file_loader::vertex> vertices = m_points.to_vertices();
+    if (m_digital_camera_params.devices.size() >= 3) {
+        camera_colorizer::colorize(vertices, m_digital_camera_params, m_digital_camera_images);
+    }
+    mesh_exporter::export_statistics statistics;
+    if (mesh_exporter::write_mesh(mesh_file, vertices, m_mesh_indices, &statistics)) {
+        std::cout << "Exported " << statistics.vertices << " vertices and " << statistics.triangles << " triangles to " << mesh_file
+            << " in " << statistics.seconds * 1000.0 << " ms" << std::endl;
+    }
+}
+
+void application::compare_xyz_loaders() const {
+    if (m_xyz_file.empty()) {
+        return;
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    const auto stream_vertices = file_loader::load_xyz_file(m_xyz_file);
+    const double stream_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+    file_loader::load_statistics mapped_statistics;
+    const auto mapped_vertices = file_loader::load_xyz_file_mapped(m_xyz_file, &mapped_statistics);
+
+    const bool is_identical = stream_vertices.size() == mapped_vertices.size() &&
+        std::equal(stream_vertices.begin(), stream_vertices.end(), mapped_vertices.begin(),
+                   [](const file_loader::vertex& a, const file_loader::vertex& b) {
+                       return a.position == b.position && a.color == b.color;
+                   });
+
+    std::cout << "ifstream loader: " << stream_seconds * 1000.0 << " ms ("
+        << (double)mapped_statistics.bytes / (1024.0 * 1024.0) / stream_seconds << " MB/s, "
+        << (double)mapped_statistics.points / stream_seconds << " points/s)" << std::endl;
+    std::cout << "mapped loader: " << mapped_statistics.seconds * 1000.0 << " ms ("
+        << mapped_statistics.mb_per_second() << " MB/s, " << mapped_statistics.points_per_second() << " points/s), "
+        << "speedup: " << stream_seconds / mapped_statistics.seconds << "x, identical output: " << (is_identical ? "yes" : "no") << std::endl;
+}
+
+void application::compare_obj_parsers() const {
+    obj_parser_benchmark::result result;
+    if (obj_parser_benchmark::run(m_obj_file, result)) {
+        obj_parser_benchmark::print(result);
+    }
+}
+
 void application::init_point_visualization() {
-    m_particle_buffer.BufferData(m_vertices);
+    const std::vector<size_t> offsets = buffer_point_cloud(m_particle_buffer, m_points);
     m_particle_vao.Init({
-        {AttributeData{0, 3, GL_FLOAT, GL_FALSE, sizeof(file_loader::vertex), (void*)offsetof(file_loader::vertex, position)}, m_particle_buffer},
-        {AttributeData{1, 3, GL_FLOAT, GL_FALSE, sizeof(file_loader::vertex), (void*)offsetof(file_loader::vertex, color)}, m_particle_buffer}
+        {AttributeData{0, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)offsets[0]}, m_particle_buffer},
+        {AttributeData{3, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)offsets[1]}, m_particle_buffer},
+        {AttributeData{4, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)offsets[2]}, m_particle_buffer},
+        {AttributeData{1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)offsets[3]}, m_particle_buffer}
     });
 }
 
+std::vector<size_t> application::buffer_point_cloud(ArrayBuffer& buffer, const point_cloud& points) {
+    // the x, y, z and color arrays are copied one after the other, the shader assembles the position from three floats
+    const point_cloud::attribute_view views[] = {points.get_x_view(), points.get_y_view(), points.get_z_view(), points.get_color_view()};
+    std::vector<size_t> offsets;
+    size_t size = 0;
+    for (const auto& view : views) {
+        offsets.push_back(size);
+        size += view.get_byte_size();
+    }
+    buffer.BufferData(size);
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        if (views[i].count > 0) {
+            buffer.BufferSubData(offsets[i], views[i].get_byte_size(), views[i].data);
+        }
+    }
+    return offsets;
+}
+
 void application::init_debug_sphere() {
     m_debug_sphere.resize((m_debug_sphere_m + 1) * (m_debug_sphere_n + 1));
     for (int i = 0; i <= m_debug_sphere_n; ++i)
         for (int j = 0; j <= m_debug_sphere_m; ++j)
-            m_debug_sphere[i + j * (m_debug_sphere_n + 1)] = get_sphere_pos(
+            m_debug_sphere.set_position(i + j * (m_debug_sphere_n + 1), get_sphere_pos(
                 (float)(i) / (float)(m_debug_sphere_n),
-                (float)(j) / (float)(m_debug_sphere_m));
-    m_debug_sphere_buffer.BufferData(m_debug_sphere);
-    m_debug_sphere_vao.Init({{CreateAttribute<0, glm::vec3, 0, sizeof(glm::vec3)>, m_debug_sphere_buffer}});
+                (float)(j) / (float)(m_debug_sphere_m)));
+    // the same x, y, z streams as the particles, without colors the color attribute keeps its constant default
+    const std::vector<size_t> offsets = buffer_point_cloud(m_debug_sphere_buffer, m_debug_sphere);
+    m_debug_sphere_vao.Init({
+        {AttributeData{0, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)offsets[0]}, m_debug_sphere_buffer},
+        {AttributeData{3, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)offsets[1]}, m_debug_sphere_buffer},
+        {AttributeData{4, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)offsets[2]}, m_debug_sphere_buffer}
+    });
 }
 
-void application::init_octree(const std::vector<file_loader::vertex>& vertices) {
-    const auto [tlf, brb] = octree::calc_boundary(vertices);
-    m_octree = octree(tlf, brb);
-    for (int i = 0; i < vertices.size(); ++i) {
-        if (vertices[i].position != glm::vec3(0, 0, 0)) {
-            m_octree.insert(vertices[i].position);
-        }
+void application::init_octree(const point_cloud& points) {
+    const linear_octree::build_statistics statistics = reconstruction_pipeline::build_octree(points, get_pipeline_settings(), m_octree);
+    if (statistics.duplicate_points > 0) {
+        std::cout << "Left " << statistics.duplicate_points << " duplicate points out of the octree" << std::endl;
     }
 }
 
@@ -244,31 +436,16 @@ void application::init_box(const glm::vec3& tlf, const glm::vec3& brb, std::vect
     indices.insert(indices.end(), local_indices.begin(), local_indices.end());
 }
 
-void application::init_octree_visualization(const octree* root) {
-    if (!root)
-        return;
+void application::init_octree_visualization(const linear_octree& root) {
     m_wireframe_vertices.clear();
     m_wireframe_indices.clear();
-    std::stack<const octree*> octree_stack;
-    octree_stack.push(root);
-    while (!octree_stack.empty()) {
-        const octree* node = octree_stack.top();
-        octree_stack.pop();
-
-        if (!node->m_children.empty()) {
-            for (const auto child : node->m_children) {
-                if (child != nullptr) {
-                    octree_stack.push(child);
-                }
-            }
-        }
-        if (node->m_top_left_front != nullptr) {
-            init_box(*node->m_top_left_front,
-                     *node->m_bottom_right_back,
-                     m_wireframe_vertices,
-                     m_wireframe_indices,
-                     m_octree_color);
-        }
+    for (const linear_octree::node& node : root.get_nodes()) {
+        const octree::boundary boundary = root.get_node_boundary(node);
+        init_box(boundary.m_top_left_front,
+                 boundary.m_bottom_right_back,
+                 m_wireframe_vertices,
+                 m_wireframe_indices,
+                 m_octree_color);
     }
     m_wireframe_vertices_buffer.BufferData(m_wireframe_vertices);
     m_wireframe_indices_buffer.BufferData(m_wireframe_indices);
@@ -292,27 +469,15 @@ void application::init_octree_visualization(const octree* root) {
 }
 
 void application::init_mesh_visualization() {
-    m_mesh_indices.clear();
-    for (int i = 0; i < m_render_points_up_to_index; ++i) {
-        if ((i % 16) != 15 && i < m_render_points_up_to_index - 16) {
-            if (is_outside_of_sensor_rig_boundary(i, i + 1, i + 17) && is_mesh_vertex_cut_distance_ok(i, i + 1, i + 17)) {
-                m_mesh_indices.push_back(i + 0);
-                m_mesh_indices.push_back(i + 1);
-                m_mesh_indices.push_back(i + 17);
-            }
-            if (is_outside_of_sensor_rig_boundary(i, i + 17, i + 16) && is_mesh_vertex_cut_distance_ok(i, i + 17, i + 16)) {
-                m_mesh_indices.push_back(i + 0);
-                m_mesh_indices.push_back(i + 17);
-                m_mesh_indices.push_back(i + 16);
-            }
-        }
-    }
-    m_mesh_pos_buffer.BufferData(m_vertices);
+    reconstruction_pipeline::build_ring_mesh(m_points, m_render_points_up_to_index, get_pipeline_settings(), m_mesh_indices);
+    const std::vector<size_t> offsets = buffer_point_cloud(m_mesh_pos_buffer, m_points);
     m_mesh_indices_buffer.BufferData(m_mesh_indices);
     m_mesh_vao.Init(
         {
-            {AttributeData{0, 3, GL_FLOAT, GL_FALSE, sizeof(file_loader::vertex), (void*)offsetof(file_loader::vertex, position)}, m_mesh_pos_buffer},
-            {AttributeData{1, 3, GL_FLOAT, GL_FALSE, sizeof(file_loader::vertex), (void*)offsetof(file_loader::vertex, color)}, m_mesh_pos_buffer}
+            {AttributeData{0, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)offsets[0]}, m_mesh_pos_buffer},
+            {AttributeData{3, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)offsets[1]}, m_mesh_pos_buffer},
+            {AttributeData{4, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)offsets[2]}, m_mesh_pos_buffer},
+            {AttributeData{1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)offsets[3]}, m_mesh_pos_buffer}
         },
         m_mesh_indices_buffer);
 }
@@ -338,7 +503,7 @@ void application::init_sensor_rig_boundary_visualization() {
 }
 
 void application::init_delaunay_shaded_points_segment() {
-    m_delaunay_vertices = filter_shaded_points(m_vertices);
+    m_delaunay_vertices = reconstruction_pipeline::filter_shaded_points(m_points, m_digital_camera_params, m_sensor_rig_boundary).to_vertices();
     init_delaunay();
 }
 
@@ -348,13 +513,7 @@ void application::init_delaunay_cube() {
 }
 
 void application::init_delaunay() {
-    m_delaunay = delaunay_3d(200.0f, glm::vec3(0.0f, 0.0f, 120.0f));
-    for (int i = 0; i < std::min((int)m_delaunay_vertices.size(), 200); ++i) {
-        m_delaunay.insert_point(m_delaunay_vertices[i]);
-    }
-    for (int i = 0; i < 4; ++i) {
-        m_delaunay.cleanup_super_tetrahedron();
-    }
+    reconstruction_pipeline::build_delaunay(m_delaunay_vertices, 200, m_delaunay);
     init_delaunay_visualization();
 }
 
@@ -427,6 +586,91 @@ void application::render_imgui() {
             if (ImGui::Button("load folder")) {
                 load_inputs_from_folder(m_input_folder);
             }
+            if (ImGui::Button("load las file")) {
+                m_sequence_player.stop();
+                m_live_receiver.stop();
+                file_loader::las_header header;
+                std::vector<file_loader::vertex> vertices = file_loader::load_las_file(m_input_folder, &header);
+                std::cout << "Loaded " << vertices.size() << " points from " << m_input_folder << std::endl;
+                apply_frame(vertices, {}, header.has_colors());
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("export shaded points as las")) {
+                std::string las_file = m_input_folder;
+                while (!las_file.empty() && (las_file.back() == '\\' || las_file.back() == '/')) {
+                    las_file.pop_back();
+                }
+                las_file += "_shaded.las";
+                if (file_loader::write_las_file(las_file, m_delaunay_vertices)) {
+                    std::cout << "Exported " << m_delaunay_vertices.size() << " points to " << las_file << std::endl;
+                }
+            }
+            ImGui::InputInt("frame number", &m_dataset_frame_number);
+            ImGui::SameLine();
+            if (ImGui::Button("load frame")) {
+                load_dataset_frame(m_dataset_frame_number);
+            }
+            ImGui::Text("dataset: %d frames in %s", (int)m_dataset.get_frames().size(), m_dataset_manifest_path.c_str());
+            ImGui::Checkbox("use frame cache", &m_use_frame_cache);
+            ImGui::Text("last xyz load: %.2f ms, %.1f MB/s, %.0f points/s",
+                        m_last_load_statistics.seconds * 1000.0,
+                        m_last_load_statistics.mb_per_second(),
+                        m_last_load_statistics.points_per_second());
+            if (ImGui::Button("compare xyz loaders")) {
+                compare_xyz_loaders();
+            }
+            ImGui::InputText("obj file", m_obj_file, sizeof(m_obj_file));
+            ImGui::SameLine();
+            if (ImGui::Button("compare obj parsers")) {
+                compare_obj_parsers();
+            }
+        }
+        if (ImGui::CollapsingHeader("sequence")) {
+            if (ImGui::Button("play folder, pcap or archive as sequence")) {
+                if (m_digital_camera_params.devices.empty()) {
+                    m_digital_camera_params = file_loader::load_digital_camera_params("inputs\\CameraParametersMinimal.txt");
+                }
+                m_live_receiver.stop();
+                m_sequence_player.start(m_input_folder, m_sequence_frames_per_second, m_sequence_prefetch_count);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("stop sequence")) {
+                m_sequence_player.stop();
+            }
+            if (ImGui::Button("archive folder sequence")) {
+                std::string archive_file = m_input_folder;
+                while (!archive_file.empty() && (archive_file.back() == '\\' || archive_file.back() == '/')) {
+                    archive_file.pop_back();
+                }
+                frame_archive::convert_folder(m_input_folder, archive_file + ".srarc");
+            }
+            if (ImGui::SliderFloat("frames per second", &m_sequence_frames_per_second, 1.0f, 30.0f)) {
+                m_sequence_player.set_frames_per_second(m_sequence_frames_per_second);
+            }
+            ImGui::SliderInt("prefetched frames", &m_sequence_prefetch_count, 1, 8);
+            ImGui::Text("frame fn%d (%d / %d), buffered: %d, late: %d",
+                        m_sequence_frame_number,
+                        (int)m_sequence_frame_index + 1,
+                        (int)m_sequence_player.get_frame_count(),
+                        (int)m_sequence_player.get_buffered_frame_count(),
+                        (int)m_sequence_player.get_late_frame_count());
+        }
+        if (ImGui::CollapsingHeader("live")) {
+            ImGui::InputInt("udp port", &m_live_port);
+            if (ImGui::Button("start listening")) {
+                m_sequence_player.stop();
+                m_live_receiver.start((uint16_t)m_live_port);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("stop listening")) {
+                m_live_receiver.stop();
+            }
+            ImGui::Text("%s, revolution %d, packets: %d, revolutions: %d, dropped: %d",
+                        m_live_receiver.is_running() ? "listening" : "stopped",
+                        (int)m_live_frame_index,
+                        (int)m_live_receiver.get_packet_count(),
+                        (int)m_live_receiver.get_frame_count(),
+                        (int)m_live_receiver.get_dropped_frame_count());
         }
         if (ImGui::CollapsingHeader("points")) {
             ImGui::Checkbox("show points", &m_show_points);
@@ -435,6 +679,12 @@ void application::render_imgui() {
             ImGui::SameLine();
             ImGui::Checkbox("show debug sphere", &m_show_debug_sphere);
             ImGui::SliderFloat("point size", &m_point_size, 1.0f, 30.0f);
+            const bool is_palette_changed = ImGui::Combo("colormap", &m_colormap_palette, "rainbow\0grayscale\0");
+            if (ImGui::SliderInt("max intensity", &m_colormap_max_intensity, 1, 255) || is_palette_changed) {
+                apply_colormap();
+                init_point_visualization();
+                init_mesh_visualization();
+            }
             ImGui::Checkbox("auto increment rendered point index", &m_auto_increment_rendered_point_index);
             if (ImGui::Button("-1")) {
                 if (m_render_points_up_to_index > 0) {
@@ -443,11 +693,11 @@ void application::render_imgui() {
             }
             ImGui::SameLine();
             ImGui::PushID("m_render_points_up_to_index");
-            ImGui::SliderInt("", &m_render_points_up_to_index, 0, m_vertices.size());
+            ImGui::SliderInt("", &m_render_points_up_to_index, 0, get_max_render_point_index());
             ImGui::PopID();
             ImGui::SameLine();
             if (ImGui::Button("+1")) {
-                if (m_render_points_up_to_index + 1 <= m_vertices.size()) {
+                if (m_render_points_up_to_index + 1 <= get_max_render_point_index()) {
                     ++m_render_points_up_to_index;
                 }
             }
@@ -469,6 +719,11 @@ void application::render_imgui() {
                 m_mesh_rendering_mode = solid;
             }
             ImGui::SliderFloat("mesh vertex cut distance", &m_mesh_vertex_cut_distance, 0.1f, 50.0f);
+            ImGui::Combo("export format", &m_mesh_export_format, "ply\0obj\0glb\0gltf\0");
+            ImGui::SameLine();
+            if (ImGui::Button("export mesh")) {
+                export_mesh();
+            }
         }
         if (ImGui::CollapsingHeader("sensor rig")) {
             ImGui::Checkbox("show sensor rig boundary", &m_show_sensor_rig_boundary);
@@ -479,7 +734,7 @@ void application::render_imgui() {
             ImGui::Checkbox("show octree", &m_show_octree);
             ImGui::ColorEdit3("octree color", &m_octree_color[0]);
             if (ImGui::Button("apply octree color")) {
-                init_octree_visualization(&m_octree);
+                init_octree_visualization(m_octree);
             }
         }
         if (ImGui::CollapsingHeader("delaunay")) {
@@ -575,48 +830,15 @@ std::vector<file_loader::vertex> application::get_cube_vertices(const float side
     };
 }
 
-std::vector<file_loader::vertex> application::filter_shaded_points(const std::vector<file_loader::vertex>& points) {
-    std::vector<file_loader::vertex> shaded_points;
-    glm::mat3 cam_k = m_digital_camera_params.get_cam_k();
-    glm::mat3 cam_r[3];
-    glm::vec3 cam_t[3];
-    cam_r[0] = m_digital_camera_params.devices[0].r;
-    cam_r[1] = m_digital_camera_params.devices[1].r;
-    cam_r[2] = m_digital_camera_params.devices[2].r;
-    cam_t[0] = m_digital_camera_params.devices[0].t;
-    cam_t[1] = m_digital_camera_params.devices[1].t;
-    cam_t[2] = m_digital_camera_params.devices[2].t;
-
-    for (const auto& point : points) {
-        bool is_shaded = false;
-        for (int i = 0; i < 3; ++i) {
-            glm::vec3 p_tmp = cam_r[i] * (point.position - cam_t[i]);
-            const float dist = p_tmp.z;
-            p_tmp /= p_tmp.z;
-            glm::vec2 p_c;
-            p_c.x = cam_k[0][0] * p_tmp.x + cam_k[0][2];
-            p_c.y = cam_k[1][1] * -p_tmp.y + cam_k[1][2];
-            if (dist > 0 && p_c.x >= 0 && p_c.x <= 960 && p_c.y >= 0 && p_c.y <= 600) {
-                is_shaded = true;
-            }
-        }
-        if (is_shaded && !m_sensor_rig_boundary.contains(point.position)) {
-            shaded_points.push_back(point);
-        }
-    }
-    return shaded_points;
-}
-
-bool application::is_mesh_vertex_cut_distance_ok(const int i0, const int i1, const int i2) const {
-    return glm::distance(m_vertices[i0].position, m_vertices[i1].position) < m_mesh_vertex_cut_distance &&
-        glm::distance(m_vertices[i1].position, m_vertices[i2].position) < m_mesh_vertex_cut_distance &&
-        glm::distance(m_vertices[i2].position, m_vertices[i0].position) < m_mesh_vertex_cut_distance;
+reconstruction_pipeline::settings application::get_pipeline_settings() const {
+    reconstruction_pipeline::settings settings;
+    settings.sensor_rig_boundary = m_sensor_rig_boundary;
+    settings.mesh_vertex_cut_distance = m_mesh_vertex_cut_distance;
+    return settings;
 }
 
-bool application::is_outside_of_sensor_rig_boundary(const int i0, const int i1, const int i2) const {
-    return !(m_sensor_rig_boundary.contains(m_vertices[i0].position) ||
-        m_sensor_rig_boundary.contains(m_vertices[i1].position) ||
-        m_sensor_rig_boundary.contains(m_vertices[i2].position));
+int application::get_max_render_point_index() const {
+    return std::max((int)m_points.size() - active_sensor_model::beam_count, 0);
 }
 
 void application::set_particle_program_uniforms(bool show_non_shaded) {
@@ -636,33 +858,12 @@ void application::set_particle_program_uniforms(bool show_non_shaded) {
     m_particle_program.SetUniform("show_non_shaded", (int)show_non_shaded);
 }
 
-void application::randomize_vertex_colors(std::vector<file_loader::vertex>& vertices) const {
-    for (file_loader::vertex& vertex : vertices) {
-        vertex.color = get_random_color();
-    }
-}
-
-glm::vec3 application::hsl_to_rgb(const float h, const float s, const float l) const {
-    const float c = (1.0f - fabs(2.0f * l - 1.0f)) * s;
-    const float x = c * (1.0f - fabs(fmod(h / 60.0f, 2.0f) - 1.0f));
-    const float m = l - c / 2.0f;
-
-    glm::vec3 color;
-    if (h < 60.0f) {
-        color = glm::vec3(c, x, 0);
-    } else if (h < 120.0f) {
-        color = glm::vec3(x, c, 0);
-    } else if (h < 180.0f) {
-        color = glm::vec3(0, c, x);
-    } else if (h < 240.0f) {
-        color = glm::vec3(0, x, c);
-    } else if (h < 300.0f) {
-        color = glm::vec3(x, 0, c);
-    } else {
-        color = glm::vec3(c, 0, x);
+void application::apply_colormap() {
+    if (m_has_source_colors) {
+        return;
     }
-
-    return color + m;
+    const colormap map((colormap::palette)m_colormap_palette, (uint16_t)m_colormap_max_intensity);
+    map.apply(m_points);
 }
 
 glm::vec3 application::get_random_color() const {
@@ -672,7 +873,7 @@ glm::vec3 application::get_random_color() const {
     const float h = hue_distribution(gen);
     const float s = 0.5f;
     const float l = 0.5f;
-    return hsl_to_rgb(h, s, l);
+    return colormap::hsl_to_rgb(h, s, l);
 }
 
 glm::vec3 application::get_sphere_pos(const float u, const float v) const {
@@ -10,6 +10,13 @@
 #include "delaunay_3d.h"
 #include "file_loader.h"
 #include "octree.h"
+#include "frame_sequence_player.h"
+#include "dataset_manifest.h"
+#include "udp_lidar_receiver.h"
+#include "mesh_exporter.h"
+#include "reconstruction_pipeline.h"
+#include "point_cloud.h"
+#include "colormap.h"
 
 enum mesh_rendering_mode {
     none = 0,
@@ -41,13 +48,21 @@ public:
 
     // file input
     void load_inputs_from_folder(const std::string& folder_name);
+    void compare_xyz_loaders() const;
+    void compare_obj_parsers() const;
+    bool open_dataset(const std::string& folder_name);
+    void load_dataset_frame(int frame_number);
+    void export_mesh();
+    // with has_colors the vertex colors are shown as they are, otherwise the points are colored by intensity
+    void apply_frame(const std::vector<file_loader::vertex>& vertices, const std::vector<file_loader::image>& images, bool has_colors = false);
+    void apply_frame(point_cloud&& points, const std::vector<file_loader::image>& images, bool has_colors = false);
 
     // init methods
     void init_point_visualization();
     void init_debug_sphere();
-    void init_octree(const std::vector<file_loader::vertex>& vertices);
+    void init_octree(const point_cloud& points);
     static void init_box(const glm::vec3& tlf, const glm::vec3& brb, std::vector<file_loader::vertex>& vertices, std::vector<int>& indices, glm::vec3 color);
-    void init_octree_visualization(const octree* root);
+    void init_octree_visualization(const linear_octree& root);
     void init_mesh_visualization();
     void init_sensor_rig_boundary_visualization();
     void init_delaunay_shaded_points_segment();
@@ -66,12 +81,14 @@ public:
 
     // helper functions
     static std::vector<file_loader::vertex> get_cube_vertices(float side_len);
-    std::vector<file_loader::vertex> filter_shaded_points(const std::vector<file_loader::vertex>& points);
-    bool is_mesh_vertex_cut_distance_ok(int i0, int i1, int i2) const;
-    bool is_outside_of_sensor_rig_boundary(int i0, int i1, int i2) const;
+    reconstruction_pipeline::settings get_pipeline_settings() const;
+    // the ring mesh needs the next column of the last rendered point
+    int get_max_render_point_index() const;
+    // uploads the arrays of the cloud back to back, returns the byte offsets of x, y, z and the colors
+    static std::vector<size_t> buffer_point_cloud(ArrayBuffer& buffer, const point_cloud& points);
     void set_particle_program_uniforms(bool show_non_shaded);
-    void randomize_vertex_colors(std::vector<file_loader::vertex>& vertices) const;
-    glm::vec3 hsl_to_rgb(float h, float s, float l) const;
+    // colors the points by intensity with the selected palette, unless the source had colors of its own
+    void apply_colormap();
     glm::vec3 get_random_color() const;
     glm::vec3 get_sphere_pos(float u, float v) const;
     static void toggle_fullscreen(SDL_Window* win);
@@ -111,7 +128,7 @@ protected:
     std::vector<int> m_mesh_indices;
 
     // vertex vectors
-    std::vector<file_loader::vertex> m_vertices;
+    point_cloud m_points;
     std::vector<file_loader::vertex> m_delaunay_vertices;
     std::vector<file_loader::vertex> m_wireframe_vertices;
     std::vector<file_loader::vertex> m_sensor_rig_boundary_vertices;
@@ -128,6 +145,7 @@ protected:
     bool m_show_non_shaded_points;
     bool m_show_non_shaded_mesh;
     bool m_auto_increment_rendered_point_index;
+    bool m_use_frame_cache;
 
     // numeric values
     int m_render_points_up_to_index;
@@ -136,6 +154,17 @@ protected:
     float m_point_size;
     float m_mesh_vertex_cut_distance;
     float m_line_width;
+    float m_sequence_frames_per_second;
+    int m_sequence_prefetch_count;
+    int m_sequence_frame_number;
+    size_t m_sequence_frame_index;
+    int m_live_port;
+    int m_dataset_frame_number;
+    int m_mesh_export_format;
+    int m_colormap_palette;
+    int m_colormap_max_intensity;
+    bool m_has_source_colors;
+    size_t m_live_frame_index;
 
     // other objects
     SDL_Window* m_window{};
@@ -144,12 +173,22 @@ protected:
     glm::vec3 m_start_at;
     glm::vec3 m_start_up;
     glm::vec3 m_octree_color;
-    octree m_octree;
+    linear_octree m_octree;
     delaunay_3d m_delaunay;
     octree::boundary m_sensor_rig_boundary;
     mesh_rendering_mode m_mesh_rendering_mode;
     file_loader::digital_camera_params m_digital_camera_params;
     char m_input_folder[256]{};
+    char m_obj_file[256]{};
+    std::string m_xyz_file;
+    dataset_manifest m_dataset;
+    std::string m_dataset_folder;
+    std::string m_dataset_manifest_path;
+    file_loader::load_statistics m_last_load_statistics;
     Texture2D m_digital_camera_textures[3];
-    std::vector<glm::vec3> m_debug_sphere;
+    std::vector<file_loader::image> m_digital_camera_images;
+    point_cloud m_debug_sphere;
+    frame_sequence_player m_sequence_player;
+    udp_lidar_receiver m_live_receiver;
+    udp_lidar_receiver::frame m_live_frame;
 };
@@ -0,0 +1,353 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include "batch_processor.h"
+#include "dataset_manifest.h"
+#include "frame_archive.h"
+#include "image_decoder.h"
+#include "mesh_exporter.h"
+#include "velodyne_pcap_reader.h"
+
+namespace {
+    using steady_clock = std::chrono::steady_clock;
+
+    double get_seconds(const steady_clock::time_point start, const steady_clock::time_point end) {
+        return std::chrono::duration<double>(end - start).count();
+    }
+}
+
+batch_processor::batch_processor(options options) : m_options(std::move(options)) {
+    if (m_options.thread_count == 0) {
+        m_options.thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_max_frames_in_flight = m_options.max_frames_in_flight != 0 ? m_options.max_frames_in_flight : 2 * m_options.thread_count;
+    m_options.shard_count = std::max<size_t>(m_options.shard_count, 1);
+}
+
+batch_processor::report batch_processor::run(const std::vector<std::string>& inputs) {
+    const auto start_time = steady_clock::now();
+    m_report = {};
+    m_frame_counter = 0;
+    m_is_done = false;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_options.output_folder, error);
+    open_journal();
+
+    // this thread enumerates and submits the frames, blocking while too many are in flight
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < m_options.thread_count; ++i) {
+        workers.emplace_back(&batch_processor::work, this);
+    }
+    for (const std::string& input : inputs) {
+        if (!enqueue_input(input)) {
+            std::cerr << "Could not read input " << input << std::endl;
+            std::lock_guard lock(m_mutex);
+            ++m_report.failed_frames;
+        }
+    }
+    {
+        std::lock_guard lock(m_mutex);
+        m_is_done = true;
+    }
+    m_job_available.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    m_journal.close();
+    m_report.seconds = get_seconds(start_time, steady_clock::now());
+    return m_report;
+}
+
+void batch_processor::print_report(const report& report) {
+    const double frames = (double)std::max<size_t>(report.processed_frames, 1);
+    const stage_timings& timings = report.timings;
+    std::cout << "Reconstructed " << report.processed_frames << " frames in " << report.seconds << " s ("
+        << report.frames_per_second() << " frames/s), " << report.skipped_frames << " already done, "
+        << report.failed_frames << " failed" << std::endl;
+    std::cout << "Average per frame: load " << timings.load / frames * 1000.0 << " ms, crop " << timings.crop / frames * 1000.0
+        << " ms, colorize " << timings.colorize / frames * 1000.0 << " ms, mesh " << timings.mesh / frames * 1000.0
+        << " ms, write " << timings.write / frames * 1000.0 << " ms" << std::endl;
+}
+
+bool batch_processor::enqueue_input(const std::string& input) {
+    const std::string stem = std::filesystem::path(input).filename().replace_extension().string();
+    std::error_code error;
+    if (std::filesystem::is_directory(input, error)) {
+        return enqueue_dataset(input, stem);
+    }
+
+    const auto get_name = [&stem](const int frame_number) { return stem + "_fn" + std::to_string(frame_number); };
+    const file_loader::digital_camera_params& camera_params = m_options.camera_params;
+    if (frame_archive::is_archive_file(input)) {
+        // the reader maps the archive, frames are decoded by the workers concurrently
+        auto reader = std::make_shared<frame_archive_reader>();
+        if (!reader->open(input)) {
+            return false;
+        }
+        for (size_t i = 0; i < reader->get_frame_count(); ++i) {
+            const int frame_number = reader->get_entry(i).frame_number;
+            if (m_options.frame_number >= 0 && frame_number != m_options.frame_number) {
+                continue;
+            }
+            if (!is_scheduled(get_name(frame_number))) {
+                continue;
+            }
+            submit({get_name(frame_number), m_options.settings, [reader, i, frame_number, camera_params](reconstruction_pipeline::frame& frame) {
+                frame.frame_number = frame_number;
+                frame.camera_params = camera_params;
+                // cropped and meshed as a range image, the pipeline makes the points from it
+                return reader->read_frame(i, frame.image);
+            }});
+        }
+        return true;
+    }
+    if (file_loader::has_extension(input, ".pcap")) {
+        // packets can only be decoded in order, the revolutions are decoded here and handed to the workers
+        velodyne_pcap_reader reader;
+        if (!reader.open(input)) {
+            return false;
+        }
+        velodyne_pcap_reader::frame revolution;
+        while (reader.read_frame(revolution)) {
+            const int frame_number = (int)revolution.index;
+            if (m_options.frame_number >= 0 && frame_number != m_options.frame_number) {
+                continue;
+            }
+            if (!is_scheduled(get_name(frame_number))) {
+                continue;
+            }
+            auto vertices = std::make_shared<std::vector<file_loader::vertex>>(std::move(revolution.vertices));
+            submit({get_name(frame_number), m_options.settings, [vertices, frame_number, camera_params](reconstruction_pipeline::frame& frame) {
+                frame.frame_number = frame_number;
+                frame.camera_params = camera_params;
+                frame.vertices = std::move(*vertices);
+                file_loader::normalize_intensities(frame.vertices);
+                return true;
+            }});
+        }
+        return true;
+    }
+
+    const int frame_number = dataset_manifest::get_frame_number(input);
+    if (is_scheduled(get_name(frame_number))) {
+        submit({get_name(frame_number), m_options.settings, [input, frame_number, camera_params](reconstruction_pipeline::frame& frame) {
+            frame.frame_number = frame_number;
+            frame.camera_params = camera_params;
+            if (file_loader::has_extension(input, ".las")) {
+                frame.vertices = file_loader::load_las_file(input);
+            } else {
+                frame.vertices = file_loader::load_xyz_file_mapped(input);
+                file_loader::normalize_intensities(frame.vertices);
+            }
+            return !frame.vertices.empty();
+        }});
+    }
+    return true;
+}
+
+bool batch_processor::enqueue_dataset(const std::string& folder_name, const std::string& stem) {
+    auto dataset = std::make_shared<dataset_manifest>();
+    reconstruction_pipeline::settings settings = m_options.settings;
+    const std::string manifest_path = dataset_manifest::get_manifest_path(folder_name);
+    std::error_code error;
+    if (std::filesystem::exists(manifest_path, error)) {
+        if (!dataset->load(manifest_path)) {
+            return false;
+        }
+        if (!m_options.has_rig) {
+            settings.sensor_rig_boundary = dataset->rig_boundary;
+        }
+    } else {
+        dataset->set_frames(dataset_manifest::scan_folder(folder_name));
+    }
+    if (!m_options.camera_params.devices.empty()) {
+        dataset->camera_params = m_options.camera_params;
+    }
+
+    const bool decode_images = image_decoder::is_available() && dataset->camera_params.devices.size() >= 3;
+    for (size_t i = 0; i < dataset->get_frames().size(); ++i) {
+        const int frame_number = dataset->get_frames()[i].frame_number;
+        if (m_options.frame_number >= 0 && frame_number != m_options.frame_number) {
+            continue;
+        }
+        const std::string name = stem + "_fn" + std::to_string(frame_number);
+        if (!is_scheduled(name)) {
+            continue;
+        }
+        submit({name, settings, [dataset, i, decode_images](reconstruction_pipeline::frame& frame) {
+            // the frames are the unit of parallelism, so points and images are read on this worker only
+            const dataset_manifest::frame_entry& entry = dataset->get_frames()[i];
+            frame.frame_number = entry.frame_number;
+            frame.camera_params = dataset->camera_params;
+            const bool is_whole_xyz_file = entry.points.offset == 0 && entry.points.size == 0 && !frame_archive::is_archive_file(entry.points.file);
+            frame.vertices = is_whole_xyz_file
+                                 ? file_loader::load_xyz_file_mapped(entry.points.file)
+                                 : dataset_manifest::load_points(entry.points);
+            file_loader::normalize_intensities(frame.vertices);
+            frame.images.resize(3);
+            for (int camera = 0; camera < 3 && decode_images; ++camera) {
+                dataset_manifest::load_image(entry.images[camera], frame.images[camera]);
+            }
+            return !frame.vertices.empty();
+        }});
+    }
+    return true;
+}
+
+bool batch_processor::is_scheduled(const std::string& name) {
+    const size_t frame_index = m_frame_counter++;
+    if (frame_index % m_options.shard_count != m_options.shard_index) {
+        return false;
+    }
+    if (m_finished_frames.count(get_journal_key(name)) != 0) {
+        std::lock_guard lock(m_mutex);
+        ++m_report.skipped_frames;
+        return false;
+    }
+    return true;
+}
+
+void batch_processor::submit(job&& job) {
+    std::unique_lock lock(m_mutex);
+    m_slot_available.wait(lock, [this] { return m_frames_in_flight < m_max_frames_in_flight; });
+    ++m_frames_in_flight;
+    m_jobs.push_back(std::move(job));
+    lock.unlock();
+    m_job_available.notify_one();
+}
+
+void batch_processor::work() {
+    while (true) {
+        std::unique_lock lock(m_mutex);
+        m_job_available.wait(lock, [this] { return !m_jobs.empty() || m_is_done; });
+        if (m_jobs.empty()) {
+            return;
+        }
+        job job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        lock.unlock();
+
+        process(job);
+
+        lock.lock();
+        --m_frames_in_flight;
+        lock.unlock();
+        m_slot_available.notify_one();
+    }
+}
+
+void batch_processor::process(job& job) {
+    const auto load_start = steady_clock::now();
+    reconstruction_pipeline::frame frame;
+    const bool is_loaded = job.load(frame);
+    const auto load_end = steady_clock::now();
+
+    std::vector<int> mesh_indices;
+    reconstruction_pipeline::frame_statistics statistics;
+    bool is_written = false;
+    if (is_loaded) {
+        statistics = reconstruction_pipeline::process(frame, job.settings, mesh_indices);
+        const std::string output_path = (std::filesystem::path(m_options.output_folder) / job.name).string();
+        is_written = mesh_exporter::write_mesh(output_path + "." + m_options.format, frame.vertices, mesh_indices);
+        if (is_written && m_options.export_shaded_points) {
+            const auto shaded_points = reconstruction_pipeline::filter_shaded_points(frame.vertices, frame.camera_params, job.settings.sensor_rig_boundary);
+            is_written = file_loader::write_las_file(output_path + "_shaded.las", shaded_points);
+        }
+    }
+    const auto write_end = steady_clock::now();
+
+    size_t octree_node_count = 0;
+    size_t octree_memory_size = 0;
+    size_t octree_duplicate_count = 0;
+    size_t tetrahedron_count = 0;
+    if (is_written && m_options.build_octree) {
+        // the frames are already processed in parallel, one thread per tree
+        linear_octree root;
+        octree_duplicate_count = reconstruction_pipeline::build_octree(point_cloud::from_vertices(frame.vertices, false), job.settings, root, 1).duplicate_points;
+        octree_node_count = root.get_nodes().size();
+        octree_memory_size = root.get_memory_size();
+    }
+    if (is_written && m_options.delaunay_point_count > 0) {
+        const auto shaded_points = reconstruction_pipeline::filter_shaded_points(frame.vertices, frame.camera_params, job.settings.sensor_rig_boundary);
+        delaunay_3d delaunay(200.0f);
+        reconstruction_pipeline::build_delaunay(shaded_points, m_options.delaunay_point_count, delaunay);
+        tetrahedron_count = delaunay.m_tetrahedra.size();
+    }
+
+    std::lock_guard lock(m_mutex);
+    if (!is_written) {
+        std::cerr << "Could not reconstruct " << job.name << std::endl;
+        ++m_report.failed_frames;
+        return;
+    }
+    append_journal(get_journal_key(job.name));
+    ++m_report.processed_frames;
+    stage_timings& timings = m_report.timings;
+    const double write_seconds = get_seconds(load_end, write_end) - statistics.crop_seconds - statistics.colorize_seconds - statistics.mesh_seconds;
+    timings.load += get_seconds(load_start, load_end);
+    timings.crop += statistics.crop_seconds;
+    timings.colorize += statistics.colorize_seconds;
+    timings.mesh += statistics.mesh_seconds;
+    timings.write += write_seconds;
+    std::cout << job.name << ": " << frame.vertices.size() << " points, " << statistics.cropped_points << " cropped, "
+        << statistics.shaded_points << " shaded, " << statistics.triangles << " triangles";
+    if (m_options.build_octree) {
+        std::cout << ", " << octree_node_count << " octree nodes (" << octree_memory_size / 1024 << " KB, " << octree_duplicate_count << " duplicate points)";
+    }
+    if (m_options.delaunay_point_count > 0) {
+        std::cout << ", " << tetrahedron_count << " tetrahedra";
+    }
+    std::cout << std::endl;
+}
+
+std::string batch_processor::get_journal_key(const std::string& name) const {
+    // the files the frame writes, so a run into the same folder with another format or with the shaded points does
+    // not skip the frames an earlier run wrote in a different way
+    std::string key = name + "." + m_options.format;
+    if (m_options.export_shaded_points) {
+        key += '\t' + name + "_shaded.las";
+    }
+    return key;
+}
+
+void batch_processor::open_journal() {
+    const std::string journal_path = (std::filesystem::path(m_options.output_folder) / journal_file_name).string();
+    m_finished_frames.clear();
+    if (m_options.resume) {
+        std::ifstream journal(journal_path);
+        std::string key;
+        bool is_line_complete = true;
+        while (std::getline(journal, key)) {
+            // a line cut short by a crash has no newline, that frame is simply done again
+            if (journal.eof()) {
+                is_line_complete = key.empty();
+                break;
+            }
+            if (!key.empty()) {
+                m_finished_frames.insert(key);
+            }
+        }
+        if (!m_finished_frames.empty()) {
+            std::cout << "Resuming, " << m_finished_frames.size() << " frames are already in " << journal_path << std::endl;
+        }
+        m_journal.open(journal_path, std::ios::app);
+        if (!is_line_complete) {
+            m_journal << '\n';
+        }
+    } else {
+        m_journal.open(journal_path, std::ios::trunc);
+    }
+    if (!m_journal) {
+        std::cerr << "Could not open the batch journal " << journal_path << std::endl;
+    }
+}
+
+// called with m_mutex held, after the outputs of the frame are in place
+void batch_processor::append_journal(const std::string& key) {
+    m_journal << key << '\n';
+    m_journal.flush();
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "file_loader.h"
+#include "reconstruction_pipeline.h"
+
+// runs the reconstruction pipeline over whole recordings: one task per frame on a thread pool, with a bounded number
+// of frames loaded at a time. Outputs are written atomically and every finished frame is appended to a journal in the
+// output folder, so a run that was interrupted skips the frames whose outputs it already wrote.
+class batch_processor {
+public:
+    static constexpr const char* journal_file_name = "batch_journal.txt";
+
+    struct options {
+        std::string output_folder = ".";
+        std::string format = "ply";
+        // 0: one worker per hardware thread
+        size_t thread_count = 0;
+        // frames queued or being processed, 0: twice the worker count
+        size_t max_frames_in_flight = 0;
+        // the frames of all inputs are numbered in order, a shard takes every shard_count-th of them
+        size_t shard_index = 0;
+        size_t shard_count = 1;
+        // false starts over with an empty journal
+        bool resume = true;
+        // only the frame with this fnNNN number if not negative
+        int frame_number = -1;
+        // overrides the cameras of the dataset manifests when set
+        file_loader::digital_camera_params camera_params;
+        // the rig of settings wins over the one of the dataset manifests
+        bool has_rig = false;
+        reconstruction_pipeline::settings settings;
+        bool export_shaded_points = false;
+        bool build_octree = false;
+        int delaunay_point_count = 0;
+    };
+
+    // summed over all frames and workers
+    struct stage_timings {
+        double load = 0.0;
+        double crop = 0.0;
+        double colorize = 0.0;
+        double mesh = 0.0;
+        double write = 0.0;
+    };
+
+    struct report {
+        size_t processed_frames = 0;
+        size_t skipped_frames = 0;
+        size_t failed_frames = 0;
+        double seconds = 0.0;
+        stage_timings timings;
+
+        double frames_per_second() const { return seconds > 0.0 ? processed_frames / seconds : 0.0; }
+    };
+
+    explicit batch_processor(options options);
+
+    // inputs are recording folders (dataset.json or fnNNN files), .xyz, .las, .srarc or VLP-16 .pcap files
+    report run(const std::vector<std::string>& inputs);
+    static void print_report(const report& report);
+
+private:
+    struct job {
+        std::string name;
+        reconstruction_pipeline::settings settings;
+        std::function<bool(reconstruction_pipeline::frame& frame)> load;
+    };
+
+    bool enqueue_input(const std::string& input);
+    bool enqueue_dataset(const std::string& folder_name, const std::string& stem);
+    // false if the frame belongs to another shard or is already in the journal
+    bool is_scheduled(const std::string& name);
+    void submit(job&& job);
+    void work();
+    void process(job& job);
+
+    // a journal line: the output files of the frame
+    std::string get_journal_key(const std::string& name) const;
+    void open_journal();
+    void append_journal(const std::string& key);
+
+    options m_options;
+    size_t m_max_frames_in_flight = 0;
+    size_t m_frame_counter = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_job_available;
+    std::condition_variable m_slot_available;
+    std::deque<job> m_jobs;
+    size_t m_frames_in_flight = 0;
+    bool m_is_done = false;
+
+    std::unordered_set<std::string> m_finished_frames;
+    std::ofstream m_journal;
+    report m_report;
+};
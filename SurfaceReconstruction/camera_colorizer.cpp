@@ -0,0 +1,48 @@
+#include <algorithm>
+#include "camera_colorizer.h"
+
+bool camera_colorizer::project(const file_loader::digital_camera_params& params, const int camera, const glm::vec3& position, glm::vec2& uv) {
+    const file_loader::device& device = params.devices[camera];
+    const glm::vec3 p = device.r * (position - device.t);
+    if (p.z <= 0.0f) {
+        return false;
+    }
+    const float x = params.internal_params.fu * p.x / p.z + params.internal_params.u0;
+    const float y = params.internal_params.fv * -p.y / p.z + params.internal_params.v0;
+    if (x < 0.0f || x > image_width || y < 0.0f || y > image_height) {
+        return false;
+    }
+    uv = glm::vec2(x / image_width, y / image_height);
+    return true;
+}
+
+glm::vec3 camera_colorizer::sample(const file_loader::image& image, const glm::vec2& uv) {
+    const int x = std::min((int)(uv.x * (float)image.width), image.width - 1);
+    const int y = std::min((int)(uv.y * (float)image.height), image.height - 1);
+    const uint8_t* pixel = image.pixels.data() + ((size_t)y * image.width + x) * image.channels;
+    if (image.channels < 3) {
+        return glm::vec3(pixel[0] / 255.0f);
+    }
+    return glm::vec3(pixel[0], pixel[1], pixel[2]) / 255.0f;
+}
+
+size_t camera_colorizer::colorize(std::vector<file_loader::vertex>& vertices,
+                                  const file_loader::digital_camera_params& params,
+                                  const std::vector<file_loader::image>& images) {
+    constexpr int camera_order[3] = {1, 0, 2};
+    size_t shaded_count = 0;
+    for (file_loader::vertex& vertex : vertices) {
+        for (const int camera : camera_order) {
+            if (camera >= (int)params.devices.size() || camera >= (int)images.size() || images[camera].pixels.empty()) {
+                continue;
+            }
+            glm::vec2 uv;
+            if (project(params, camera, vertex.position, uv)) {
+                vertex.color = sample(images[camera], uv);
+                ++shaded_count;
+                break;
+            }
+        }
+    }
+    return shaded_count;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "file_loader.h"
+
+// projects lidar points into the digital camera images on the cpu, the same way shaders/particle.vert does,
+// so exports get the colors the viewer shows
+class camera_colorizer {
+public:
+    // the resolution the camera intrinsics are calibrated for
+    static constexpr float image_width = 960.0f;
+    static constexpr float image_height = 600.0f;
+
+    // normalized image coordinates of the point in the given camera, false if the camera does not see it
+    static bool project(const file_loader::digital_camera_params& params, int camera, const glm::vec3& position, glm::vec2& uv);
+    // nearest pixel of the image at the normalized coordinates, as a 0 - 1 color
+    static glm::vec3 sample(const file_loader::image& image, const glm::vec2& uv);
+
+    // replaces the color of every point seen by a camera with its image color, the cameras are tried in the order
+    // particle.frag uses (middle, left, right). Points no camera sees keep their color. Returns the shaded count.
+    static size_t colorize(std::vector<file_loader::vertex>& vertices,
+                           const file_loader::digital_camera_params& params,
+                           const std::vector<file_loader::image>& images);
+};
@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <cmath>
+#include "colormap.h"
+
+colormap::colormap(const palette type, const uint16_t max_intensity) :
+    m_max_intensity(std::max<uint16_t>(max_intensity, 1)),
+    m_index_scale(((uint32_t)(size - 1) << 16) / m_max_intensity) {
+    for (int i = 0; i < size; ++i) {
+        const float t = (float)i / (size - 1);
+        if (type == grayscale) {
+            m_colors[i] = glm::vec3(t);
+        } else {
+            // blue for weak returns to red for strong ones, the saturation and lightness of the viewer's point colors
+            m_colors[i] = hsl_to_rgb(240.0f * (1.0f - t), 0.5f, 0.5f);
+        }
+    }
+}
+
+void colormap::apply(point_cloud& points) const {
+    points.enable_colors();
+    apply(points.get_intensities(), points.size(), points.get_colors());
+}
+
+void colormap::apply(const uint16_t* intensities, const size_t count, glm::vec3* colors) const {
+    for (size_t i = 0; i < count; ++i) {
+        colors[i] = m_colors[get_index(intensities[i])];
+    }
+}
+
+glm::vec3 colormap::hsl_to_rgb(const float h, const float s, const float l) {
+    const float c = (1.0f - std::fabs(2.0f * l - 1.0f)) * s;
+    const float x = c * (1.0f - std::fabs(std::fmod(h / 60.0f, 2.0f) - 1.0f));
+    const float m = l - c / 2.0f;
+
+    glm::vec3 color;
+    if (h < 60.0f) {
+        color = glm::vec3(c, x, 0);
+    } else if (h < 120.0f) {
+        color = glm::vec3(x, c, 0);
+    } else if (h < 180.0f) {
+        color = glm::vec3(0, c, x);
+    } else if (h < 240.0f) {
+        color = glm::vec3(0, x, c);
+    } else if (h < 300.0f) {
+        color = glm::vec3(x, 0, c);
+    } else {
+        color = glm::vec3(c, 0, x);
+    }
+
+    return color + m;
+}
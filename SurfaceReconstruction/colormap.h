@@ -0,0 +1,37 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "point_cloud.h"
+
+// intensity -> color lookup table, built once per palette and range so coloring a frame is one table read per point
+class colormap {
+public:
+    enum palette {
+        rainbow = 0,
+        grayscale = 1
+    };
+
+    static constexpr int size = 256;
+
+    // intensities from 0 to max_intensity are spread over the table, higher ones get the last color
+    explicit colormap(palette type = rainbow, uint16_t max_intensity = 255);
+
+    glm::vec3 get_color(const uint16_t intensity) const { return m_colors[get_index(intensity)]; }
+    // writes the colors of the cloud, enabling them if needed
+    void apply(point_cloud& points) const;
+    void apply(const uint16_t* intensities, size_t count, glm::vec3* colors) const;
+
+    // h in degrees, s and l in [0, 1]
+    static glm::vec3 hsl_to_rgb(float h, float s, float l);
+
+private:
+    int get_index(const uint16_t intensity) const {
+        return (int)(((uint32_t)std::min(intensity, m_max_intensity) * m_index_scale) >> 16);
+    }
+
+    glm::vec3 m_colors[size];
+    uint16_t m_max_intensity;
+    // 16.16 fixed point (size - 1) / max_intensity, intensities are clamped first so the product fits in 32 bits
+    uint32_t m_index_scale;
+};
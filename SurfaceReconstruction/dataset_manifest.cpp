@@ -0,0 +1,237 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <map>
+#include "dataset_manifest.h"
+#include "frame_archive.h"
+#include "image_decoder.h"
+#include "json_conversions.h"
+#include "mapped_file.h"
+
+namespace {
+    nlohmann::json range_to_json(const dataset_manifest::file_range& range, const std::filesystem::path& base_directory) {
+        nlohmann::json json = {{"file", std::filesystem::path(range.file).lexically_relative(base_directory).generic_string()}};
+        if (range.offset != 0 || range.size != 0) {
+            json["offset"] = range.offset;
+            json["size"] = range.size;
+        }
+        return json;
+    }
+
+    dataset_manifest::file_range range_from_json(const nlohmann::json& json, const std::filesystem::path& base_directory) {
+        dataset_manifest::file_range range;
+        if (json.is_null()) {
+            return range;
+        }
+        range.file = (base_directory / json.at("file").get<std::string>()).string();
+        range.offset = json.value("offset", (uint64_t)0);
+        range.size = json.value("size", (uint64_t)0);
+        return range;
+    }
+
+    // the part of a mapped file a range covers, fails if the range does not fit
+    bool get_range_bytes(const mapped_file& file, const dataset_manifest::file_range& range, const char*& begin, const char*& end) {
+        if (!file.is_open() || range.offset > file.size() || (range.size != 0 && range.size > file.size() - range.offset)) {
+            std::cerr << "Byte range " << range.offset << " + " << range.size << " is outside of " << range.file << std::endl;
+            return false;
+        }
+        begin = file.data() + range.offset;
+        end = range.size != 0 ? begin + range.size : file.end();
+        return true;
+    }
+}
+
+octree::boundary dataset_manifest::get_default_rig_boundary() {
+    return octree::boundary{glm::vec3(-2.3f, -1.7f, -0.5f), glm::vec3(1.7f, 0.4f, 0.7f)};
+}
+
+std::string dataset_manifest::get_manifest_path(const std::string& folder_name) {
+    return (std::filesystem::path(folder_name) / file_name).string();
+}
+
+int dataset_manifest::get_frame_number(const std::string& file_name) {
+    const size_t position = file_name.rfind("_fn");
+    if (position == std::string::npos) {
+        return -1;
+    }
+    int frame_number = 0;
+    size_t i = position + 3;
+    if (i >= file_name.size() || !isdigit((unsigned char)file_name[i])) {
+        return -1;
+    }
+    for (; i < file_name.size() && isdigit((unsigned char)file_name[i]); ++i) {
+        frame_number = frame_number * 10 + (file_name[i] - '0');
+    }
+    return frame_number;
+}
+
+std::vector<dataset_manifest::frame_entry> dataset_manifest::scan_folder(const std::string& folder_name) {
+    std::map<int, frame_entry> frames_by_number;
+    for (const auto& path : file_loader::get_directory_files(folder_name)) {
+        const std::string name = std::filesystem::path(path).filename().string();
+        if (name == file_name) {
+            continue;
+        }
+        // files without an fnNNN tag belong to a single unnumbered frame
+        const int frame_number = std::max(get_frame_number(name), 0);
+
+        frame_entry& frame = frames_by_number[frame_number];
+        frame.frame_number = frame_number;
+        if (name.find("Dev0") == 0) {
+            frame.images[0].file = path;
+        } else if (name.find("Dev1") == 0) {
+            frame.images[1].file = path;
+        } else if (name.find("Dev2") == 0) {
+            frame.images[2].file = path;
+        } else if (name.find(".xyz") != std::string::npos) {
+            frame.points.file = path;
+        }
+    }
+
+    std::vector<frame_entry> frames;
+    frames.reserve(frames_by_number.size());
+    for (auto& [frame_number, frame] : frames_by_number) {
+        if (!frame.points.empty()) {
+            frames.push_back(std::move(frame));
+        }
+    }
+    return frames;
+}
+
+bool dataset_manifest::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Could not open file: " << path << std::endl;
+        return false;
+    }
+    const std::filesystem::path base_directory = std::filesystem::path(path).parent_path();
+
+    try {
+        nlohmann::json json;
+        file >> json;
+        if (json.at("version").get<int>() != version) {
+            std::cerr << "Unsupported dataset manifest version in " << path << std::endl;
+            return false;
+        }
+        sensor_model = json.at("sensor_model").get<std::string>();
+        json.at("cameras").get_to(camera_params);
+        json.at("rig_boundary").at("min").get_to(rig_boundary.m_top_left_front);
+        json.at("rig_boundary").at("max").get_to(rig_boundary.m_bottom_right_back);
+
+        const auto& frames_json = json.at("frames");
+        std::vector<frame_entry> frames;
+        frames.reserve(frames_json.size());
+        for (const auto& frame_json : frames_json) {
+            frame_entry frame;
+            frame.frame_number = frame_json.at("frame_number").get<int>();
+            frame.points = range_from_json(frame_json.at("points"), base_directory);
+            const auto& images_json = frame_json.value("images", nlohmann::json::array());
+            for (int i = 0; i < 3 && i < (int)images_json.size(); ++i) {
+                frame.images[i] = range_from_json(images_json[i], base_directory);
+            }
+            frames.push_back(std::move(frame));
+        }
+        set_frames(std::move(frames));
+    } catch (const nlohmann::json::exception& exception) {
+        std::cerr << "Invalid dataset manifest " << path << ": " << exception.what() << std::endl;
+        return false;
+    }
+
+    if (sensor_model != active_sensor_model::name) {
+        std::cerr << "Warning: " << path << " was recorded with a " << sensor_model << ", the application is built for a "
+            << active_sensor_model::name << std::endl;
+    }
+    return true;
+}
+
+bool dataset_manifest::save(const std::string& path) const {
+    const std::filesystem::path base_directory = std::filesystem::path(path).parent_path();
+
+    nlohmann::json frames_json = nlohmann::json::array();
+    for (const auto& frame : m_frames) {
+        nlohmann::json images_json = nlohmann::json::array();
+        for (const auto& image : frame.images) {
+            images_json.push_back(image.empty() ? nlohmann::json() : range_to_json(image, base_directory));
+        }
+        frames_json.push_back({
+            {"frame_number", frame.frame_number},
+            {"points", range_to_json(frame.points, base_directory)},
+            {"images", images_json}
+        });
+    }
+
+    const nlohmann::json json = {
+        {"version", version},
+        {"sensor_model", sensor_model},
+        {"cameras", camera_params},
+        {"rig_boundary", {{"min", rig_boundary.m_top_left_front}, {"max", rig_boundary.m_bottom_right_back}}},
+        {"frames", frames_json}
+    };
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file) {
+        std::cerr << "Could not write dataset manifest: " << path << std::endl;
+        return false;
+    }
+    file << json.dump(4) << std::endl;
+    return (bool)file;
+}
+
+void dataset_manifest::set_frames(std::vector<frame_entry> frames) {
+    m_frames = std::move(frames);
+    m_frame_lookup.clear();
+    m_frame_lookup.reserve(m_frames.size());
+    for (size_t i = 0; i < m_frames.size(); ++i) {
+        m_frame_lookup.emplace(m_frames[i].frame_number, i);
+    }
+}
+
+const dataset_manifest::frame_entry* dataset_manifest::find_frame(const int frame_number) const {
+    const auto it = m_frame_lookup.find(frame_number);
+    return it != m_frame_lookup.end() ? &m_frames[it->second] : nullptr;
+}
+
+std::vector<file_loader::vertex> dataset_manifest::load_points(const file_range& range) {
+    const mapped_file file(range.file);
+    const char* begin;
+    const char* end;
+    if (!get_range_bytes(file, range, begin, end)) {
+        return {};
+    }
+
+    if (frame_archive::is_archive_file(range.file)) {
+        std::vector<file_loader::vertex> vertices;
+        if (!frame_archive::decode_frame(reinterpret_cast<const uint8_t*>(begin), end - begin, vertices)) {
+            std::cerr << "Corrupt archive frame at offset " << range.offset << " of " << range.file << std::endl;
+            return {};
+        }
+        return vertices;
+    }
+    return file_loader::parse_xyz_buffer(begin, end);
+}
+
+point_cloud dataset_manifest::load_point_cloud(const file_range& range) {
+    if (frame_archive::is_archive_file(range.file)) {
+        return point_cloud::from_vertices(load_points(range), false);
+    }
+    const mapped_file file(range.file);
+    const char* begin;
+    const char* end;
+    if (!get_range_bytes(file, range, begin, end)) {
+        return {};
+    }
+    return file_loader::parse_xyz_point_cloud(begin, end);
+}
+
+bool dataset_manifest::load_image(const file_range& range, file_loader::image& image) {
+    if (range.offset == 0 && range.size == 0) {
+        return image_decoder::decode_file(range.file, image);
+    }
+    const mapped_file file(range.file);
+    const char* begin;
+    const char* end;
+    if (!get_range_bytes(file, range, begin, end)) {
+        return false;
+    }
+    return image_decoder::decode_memory(begin, end - begin, image, range.file);
+}
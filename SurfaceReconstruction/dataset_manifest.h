@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "file_loader.h"
+#include "octree.h"
+#include "point_cloud.h"
+
+// dataset.json next to the recordings: cameras, sensor rig boundary, sensor model and a frame table whose entries
+// point at byte ranges of the point and image files, so a frame is found without listing or matching the folder
+class dataset_manifest {
+public:
+    static constexpr int version = 1;
+    static constexpr const char* file_name = "dataset.json";
+
+    // size 0 means the whole file from offset
+    struct file_range {
+        std::string file;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+
+        bool empty() const { return file.empty(); }
+    };
+
+    struct frame_entry {
+        int frame_number = -1;
+        file_range points;
+        file_range images[3];
+    };
+
+    std::string sensor_model = active_sensor_model::name;
+    file_loader::digital_camera_params camera_params;
+    octree::boundary rig_boundary = get_default_rig_boundary();
+
+    static octree::boundary get_default_rig_boundary();
+    static std::string get_manifest_path(const std::string& folder_name);
+    static int get_frame_number(const std::string& file_name);
+
+    // the one directory scan: groups the Dev0/1/2 images and the xyz file of every fnNNN frame into the frame table
+    static std::vector<frame_entry> scan_folder(const std::string& folder_name);
+
+    bool load(const std::string& path);
+    // paths are written relative to the manifest
+    bool save(const std::string& path) const;
+
+    const std::vector<frame_entry>& get_frames() const { return m_frames; }
+    void set_frames(std::vector<frame_entry> frames);
+    // hash lookup, independent of the number of frames
+    const frame_entry* find_frame(int frame_number) const;
+
+    // points are read from .xyz text or from a frame of a .srarc archive
+    static std::vector<file_loader::vertex> load_points(const file_range& range);
+    // the same points as positions and intensities, xyz text is parsed straight into the arrays of the cloud
+    static point_cloud load_point_cloud(const file_range& range);
+    static bool load_image(const file_range& range, file_loader::image& image);
+
+private:
+    std::vector<frame_entry> m_frames;
+    std::unordered_map<int, size_t> m_frame_lookup;
+};
@@ -171,7 +171,11 @@ public:
     }
 
     void insert_point(const file_loader::vertex& point) {
-        if (!m_root.is_point_in_tetrahedron(point.position)) {
+        insert_point(point.position);
+    }
+
+    void insert_point(const glm::vec3& position) {
+        if (!m_root.is_point_in_tetrahedron(position)) {
             return;
         }
 
@@ -179,7 +183,7 @@ public:
         m_bad_tetrahedra.clear();
         for (tetrahedron& tetrahedron : m_tetrahedra) {
             // first find all the _tetrahedra that are no longer valid due to the insertion
-            if (tetrahedron.is_point_inside_circumsphere(point.position)) {
+            if (tetrahedron.is_point_inside_circumsphere(position)) {
                 m_bad_tetrahedra.push_back(tetrahedron);
             }
         }
@@ -199,10 +203,10 @@ public:
         for (const face& face : m_poly_body) {
             // re-triangulate the polygonal hole
             tetrahedron new_tetrahedron;
-            if (get_side(face.c, face.b, face.a, point.position)) {
-                new_tetrahedron = tetrahedron(face.a, face.b, face.c, point.position);
+            if (get_side(face.c, face.b, face.a, position)) {
+                new_tetrahedron = tetrahedron(face.a, face.b, face.c, position);
             } else {
-                new_tetrahedron = tetrahedron(face.c, face.b, face.a, point.position);
+                new_tetrahedron = tetrahedron(face.c, face.b, face.a, position);
             }
             m_tetrahedra.push_back(new_tetrahedron);
         }
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "entropy_coder.h"
+
+namespace {
+    constexpr uint32_t rans_lower_bound = 1u << 23;
+    constexpr uint8_t raw_block = 0;
+    constexpr uint8_t rans_block = 1;
+
+    // scales the histogram to probability_scale while keeping every occurring symbol at least 1
+    void normalize_frequencies(const std::array<uint32_t, 256>& counts, const size_t total, std::array<uint32_t, 256>& frequencies) {
+        uint32_t sum = 0;
+        int largest = 0;
+        for (int s = 0; s < 256; ++s) {
+            frequencies[s] = 0;
+            if (counts[s] == 0) {
+                continue;
+            }
+            frequencies[s] = std::max<uint32_t>(1, (uint32_t)((uint64_t)counts[s] * entropy_coder::probability_scale / total));
+            sum += frequencies[s];
+            if (counts[s] > counts[largest]) {
+                largest = s;
+            }
+        }
+
+        // the rounding error is settled on the most frequent symbols, never pushing one below 1
+        while (sum != entropy_coder::probability_scale) {
+            if (sum < entropy_coder::probability_scale) {
+                frequencies[largest] += entropy_coder::probability_scale - sum;
+                sum = entropy_coder::probability_scale;
+                continue;
+            }
+            int candidate = -1;
+            for (int s = 0; s < 256; ++s) {
+                if (frequencies[s] > 1 && (candidate < 0 || frequencies[s] > frequencies[candidate])) {
+                    candidate = s;
+                }
+            }
+            const uint32_t reduction = std::min(sum - entropy_coder::probability_scale, frequencies[candidate] - 1);
+            frequencies[candidate] -= reduction;
+            sum -= reduction;
+        }
+    }
+
+    void append_raw(const uint8_t* data, const size_t size, std::vector<uint8_t>& output) {
+        output.push_back(raw_block);
+        entropy_coder::write_varint(size, output);
+        output.insert(output.end(), data, data + size);
+    }
+}
+
+void entropy_coder::write_varint(uint64_t value, std::vector<uint8_t>& output) {
+    while (value >= 0x80) {
+        output.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    output.push_back((uint8_t)value);
+}
+
+bool entropy_coder::read_varint(const uint8_t*& it, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (it == end) {
+            return false;
+        }
+        const uint8_t byte = *it++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void entropy_coder::encode(const uint8_t* data, const size_t size, std::vector<uint8_t>& output) {
+    if (size < 64) {
+        append_raw(data, size, output);
+        return;
+    }
+
+    std::array<uint32_t, 256> counts{};
+    for (size_t i = 0; i < size; ++i) {
+        ++counts[data[i]];
+    }
+    std::array<uint32_t, 256> frequencies;
+    normalize_frequencies(counts, size, frequencies);
+    std::array<uint32_t, 256> starts;
+    uint32_t start = 0;
+    for (int s = 0; s < 256; ++s) {
+        starts[s] = start;
+        start += frequencies[s];
+    }
+
+    // rANS emits bytes back to front, the symbols are encoded in reverse so the decoder runs forwards
+    std::vector<uint8_t> encoded(size + size / 2 + 16);
+    uint8_t* begin = encoded.data();
+    uint8_t* it = encoded.data() + encoded.size();
+    uint32_t state = rans_lower_bound;
+    for (size_t i = size; i-- > 0;) {
+        const uint32_t frequency = frequencies[data[i]];
+        const uint32_t state_max = ((rans_lower_bound >> probability_bits) << 8) * frequency;
+        while (state >= state_max) {
+            if (it == begin) {
+                append_raw(data, size, output);
+                return;
+            }
+            *--it = (uint8_t)state;
+            state >>= 8;
+        }
+        state = ((state / frequency) << probability_bits) + state % frequency + starts[data[i]];
+    }
+    if (it - begin < 4) {
+        append_raw(data, size, output);
+        return;
+    }
+    it -= 4;
+    std::memcpy(it, &state, sizeof(state));
+
+    std::vector<uint8_t> table;
+    int symbol_count = 0;
+    for (int s = 0; s < 256; ++s) {
+        if (frequencies[s] != 0) {
+            ++symbol_count;
+            table.push_back((uint8_t)s);
+            write_varint(frequencies[s], table);
+        }
+    }
+    const size_t encoded_size = encoded.data() + encoded.size() - it;
+    if (table.size() + encoded_size + 8 >= size) {
+        append_raw(data, size, output);
+        return;
+    }
+
+    output.push_back(rans_block);
+    write_varint(size, output);
+    write_varint(symbol_count - 1, output);
+    output.insert(output.end(), table.begin(), table.end());
+    write_varint(encoded_size, output);
+    output.insert(output.end(), it, it + encoded_size);
+}
+
+bool entropy_coder::decode(const uint8_t*& it, const uint8_t* end, std::vector<uint8_t>& output) {
+    if (it == end) {
+        return false;
+    }
+    const uint8_t mode = *it++;
+    uint64_t size;
+    if (!read_varint(it, end, size)) {
+        return false;
+    }
+    if (mode == raw_block) {
+        if ((uint64_t)(end - it) < size) {
+            return false;
+        }
+        output.assign(it, it + size);
+        it += size;
+        return true;
+    }
+    if (mode != rans_block) {
+        return false;
+    }
+
+    uint64_t symbol_count;
+    if (!read_varint(it, end, symbol_count) || symbol_count > 255) {
+        return false;
+    }
+    std::array<uint32_t, 256> frequencies{};
+    std::array<uint32_t, 256> starts{};
+    std::array<uint8_t, probability_scale> slot_symbols;
+    uint32_t start = 0;
+    for (uint64_t i = 0; i <= symbol_count; ++i) {
+        uint64_t frequency;
+        if (it == end) {
+            return false;
+        }
+        const uint8_t symbol = *it++;
+        if (!read_varint(it, end, frequency) || frequency == 0 || start + frequency > probability_scale) {
+            return false;
+        }
+        frequencies[symbol] = (uint32_t)frequency;
+        starts[symbol] = start;
+        std::fill(slot_symbols.begin() + start, slot_symbols.begin() + start + frequency, symbol);
+        start += (uint32_t)frequency;
+    }
+    uint64_t encoded_size;
+    if (start != probability_scale || !read_varint(it, end, encoded_size) || encoded_size < 4 || (uint64_t)(end - it) < encoded_size) {
+        return false;
+    }
+
+    const uint8_t* encoded = it;
+    const uint8_t* encoded_end = it + encoded_size;
+    it = encoded_end;
+    uint32_t state;
+    std::memcpy(&state, encoded, sizeof(state));
+    encoded += 4;
+
+    output.resize(size);
+    for (uint64_t i = 0; i < size; ++i) {
+        const uint32_t slot = state & (probability_scale - 1);
+        const uint8_t symbol = slot_symbols[slot];
+        state = frequencies[symbol] * (state >> probability_bits) + slot - starts[symbol];
+        while (state < rans_lower_bound) {
+            if (encoded == encoded_end) {
+                return false;
+            }
+            state = state << 8 | *encoded++;
+        }
+        output[i] = symbol;
+    }
+    return true;
+}
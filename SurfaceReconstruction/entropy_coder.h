@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// order-0 byte-wise rANS coder. Every block carries its own frequency table, so separate streams of a frame
+// (ranges, intensities, ...) are modelled independently. Blocks that would not shrink are stored raw.
+class entropy_coder {
+public:
+    static constexpr int probability_bits = 12;
+    static constexpr uint32_t probability_scale = 1u << probability_bits;
+
+    // appends the encoded block to output
+    static void encode(const uint8_t* data, size_t size, std::vector<uint8_t>& output);
+    // decodes one block starting at it and advances it past the block, fails on corrupt input
+    static bool decode(const uint8_t*& it, const uint8_t* end, std::vector<uint8_t>& output);
+
+    static void write_varint(uint64_t value, std::vector<uint8_t>& output);
+    static bool read_varint(const uint8_t*& it, const uint8_t* end, uint64_t& value);
+};
@@ -8,7 +8,18 @@
 #include <algorithm>
 #include <glm/gtc/type_ptr.hpp>
 #include <filesystem>
+#include <charconv>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <sstream>
+#include <cmath>
+#include <climits>
+#include <cstdint>
 #include "file_loader.h"
+#include "mapped_file.h"
+#include "point_cloud.h"
+#include "json_conversions.h"
 
 file_loader::digital_camera_params file_loader::load_digital_camera_params(const std::string& filename) {
     digital_camera_params camera_params;
@@ -51,6 +62,28 @@ file_loader::digital_camera_params file_loader::load_digital_camera_params(const
     return camera_params;
 }
 
+file_loader::digital_camera_params file_loader::load_digital_camera_params_json(const std::string& filename) {
+    digital_camera_params camera_params;
+
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Could not open file: " << filename << std::endl;
+        return camera_params;
+    }
+
+    // operator>> stops after the first json value, anything following it in the file is ignored
+    nlohmann::json json_data;
+    try {
+        file >> json_data;
+        json_data.get_to(camera_params);
+    } catch (const nlohmann::json::exception& exception) {
+        std::cerr << "Invalid camera parameters in " << filename << ": " << exception.what() << std::endl;
+        return {};
+    }
+
+    return camera_params;
+}
+
 std::vector<file_loader::vertex> file_loader::read_vertices_from_file(std::ifstream* file, const int vertex_count) {
     std::vector<vertex> vertices;
     vertices.resize(vertex_count);
@@ -58,43 +91,550 @@ std::vector<file_loader::vertex> file_loader::read_vertices_from_file(std::ifstr
     for (int i = 0; i < vertex_count; ++i) {
         *file >> vertices[i].position.x >> vertices[i].position.y >> vertices[i].position.z;
         *file >> vertices[i].color.r >> vertices[i].color.g >> vertices[i].color.b;
-        if (i % 2 == 1)
-            vertices[i].color = {1, 0, 0};
     }
     file->close();
 
     return vertices;
 }
 
+static bool get_ply_scalar_type(const std::string& name, file_loader::ply_scalar_type& type) {
+    if (name == "char" || name == "int8") {
+        type = file_loader::ply_int8;
+    } else if (name == "uchar" || name == "uint8") {
+        type = file_loader::ply_uint8;
+    } else if (name == "short" || name == "int16") {
+        type = file_loader::ply_int16;
+    } else if (name == "ushort" || name == "uint16") {
+        type = file_loader::ply_uint16;
+    } else if (name == "int" || name == "int32") {
+        type = file_loader::ply_int32;
+    } else if (name == "uint" || name == "uint32") {
+        type = file_loader::ply_uint32;
+    } else if (name == "float" || name == "float32") {
+        type = file_loader::ply_float32;
+    } else if (name == "double" || name == "float64") {
+        type = file_loader::ply_float64;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static size_t get_ply_scalar_size(const file_loader::ply_scalar_type type) {
+    static constexpr size_t sizes[] = {1, 1, 2, 2, 4, 4, 4, 8};
+    return sizes[type];
+}
+
+bool file_loader::parse_ply_header(const char* begin, const char* end, ply_header& header) {
+    header = ply_header{};
+
+    const char* it = begin;
+    bool is_first_line = true;
+    bool is_in_vertex_element = false;
+    bool is_vertex_element_seen = false;
+    size_t current_element_count = 0;
+    size_t current_element_stride = 0;
+    bool is_current_element_fixed_size = true;
+
+    // elements before the vertex element have to be skipped, which is only possible when their records have a fixed size
+    auto finish_element = [&]() -> bool {
+        if (is_in_vertex_element || is_vertex_element_seen) {
+            return true;
+        }
+        if (!is_current_element_fixed_size && current_element_count > 0) {
+            std::cerr << "Error: PLY element with list properties before the vertex element is not supported" << std::endl;
+            return false;
+        }
+        header.vertex_data_offset += current_element_count * current_element_stride;
+        return true;
+    };
+
+    while (it < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(it, '\n', end - it));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+        std::string line(it, line_end);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        it = line_end == end ? end : line_end + 1;
+
+        if (is_first_line) {
+            if (line != "ply") {
+                std::cerr << "Error: Missing ply magic number" << std::endl;
+                return false;
+            }
+            is_first_line = false;
+            continue;
+        }
+
+        std::istringstream tokens(line);
+        std::string keyword;
+        tokens >> keyword;
+
+        if (keyword == "format") {
+            std::string format;
+            tokens >> format;
+            if (format == "ascii") {
+                header.format = ply_ascii;
+            } else if (format == "binary_little_endian") {
+                header.format = ply_binary_little_endian;
+            } else if (format == "binary_big_endian") {
+                header.format = ply_binary_big_endian;
+            } else {
+                std::cerr << "Error: Unknown PLY format: " << format << std::endl;
+                return false;
+            }
+        } else if (keyword == "element") {
+            if (!finish_element()) {
+                return false;
+            }
+            if (is_in_vertex_element) {
+                is_vertex_element_seen = true;
+            }
+            std::string name;
+            tokens >> name >> current_element_count;
+            current_element_stride = 0;
+            is_current_element_fixed_size = true;
+            is_in_vertex_element = name == "vertex";
+            if (is_in_vertex_element) {
+                header.vertex_count = current_element_count;
+            }
+        } else if (keyword == "property") {
+            std::string type_name;
+            tokens >> type_name;
+            if (type_name == "list") {
+                is_current_element_fixed_size = false;
+                if (is_in_vertex_element) {
+                    std::cerr << "Error: List properties on PLY vertices are not supported" << std::endl;
+                    return false;
+                }
+                continue;
+            }
+
+            ply_scalar_type type;
+            if (!get_ply_scalar_type(type_name, type)) {
+                std::cerr << "Error: Unknown PLY property type: " << type_name << std::endl;
+                return false;
+            }
+            std::string name;
+            tokens >> name;
+            if (is_in_vertex_element) {
+                header.vertex_properties.push_back({name, type, current_element_stride});
+            }
+            current_element_stride += get_ply_scalar_size(type);
+            if (is_in_vertex_element) {
+                header.vertex_stride = current_element_stride;
+            }
+        } else if (keyword == "end_header") {
+            if (!finish_element()) {
+                return false;
+            }
+            header.data_offset = it - begin;
+            return true;
+        }
+    }
+
+    std::cerr << "Error: Could not find end_header in PLY file" << std::endl;
+    return false;
+}
+
+template <bool swap_bytes>
+static float read_ply_scalar(const char* data, const file_loader::ply_scalar_type type) {
+    char bytes[8];
+    const size_t size = get_ply_scalar_size(type);
+    if (swap_bytes) {
+        for (size_t i = 0; i < size; ++i) {
+            bytes[i] = data[size - 1 - i];
+        }
+    } else {
+        std::memcpy(bytes, data, size);
+    }
+
+    switch (type) {
+    case file_loader::ply_int8: {
+        int8_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return (float)value;
+    }
+    case file_loader::ply_uint8: {
+        uint8_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return (float)value;
+    }
+    case file_loader::ply_int16: {
+        int16_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return (float)value;
+    }
+    case file_loader::ply_uint16: {
+        uint16_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return (float)value;
+    }
+    case file_loader::ply_int32: {
+        int32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return (float)value;
+    }
+    case file_loader::ply_uint32: {
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return (float)value;
+    }
+    case file_loader::ply_float32: {
+        float value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+    case file_loader::ply_float64: {
+        double value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return (float)value;
+    }
+    }
+    return 0.0f;
+}
+
+// integer colors are normalized to [0, 1], floating point colors are taken as they are
+static float get_ply_color_scale(const file_loader::ply_scalar_type type) {
+    switch (type) {
+    case file_loader::ply_uint8: return 1.0f / 255.0f;
+    case file_loader::ply_uint16: return 1.0f / 65535.0f;
+    case file_loader::ply_int8: return 1.0f / 127.0f;
+    case file_loader::ply_int16: return 1.0f / 32767.0f;
+    default: return 1.0f;
+    }
+}
+
+template <bool swap_bytes>
+static void decode_ply_vertices(const char* data, const file_loader::ply_header& header, const file_loader::ply_property* fields[6],
+                                std::vector<file_loader::vertex>& vertices) {
+    float scales[6] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+    for (int f = 3; f < 6; ++f) {
+        if (fields[f]) {
+            scales[f] = get_ply_color_scale(fields[f]->type);
+        }
+    }
+
+    for (size_t i = 0; i < header.vertex_count; ++i) {
+        const char* record = data + i * header.vertex_stride;
+        float values[6] = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+        for (int f = 0; f < 6; ++f) {
+            if (fields[f]) {
+                values[f] = read_ply_scalar<swap_bytes>(record + fields[f]->offset, fields[f]->type) * scales[f];
+            }
+        }
+        vertices[i].position = glm::vec3(values[0], values[1], values[2]);
+        vertices[i].color = glm::vec3(values[3], values[4], values[5]);
+    }
+}
+
+std::vector<file_loader::vertex> file_loader::read_binary_ply_vertices(const char* data, const size_t size, const ply_header& header) {
+    const ply_property* fields[6] = {
+        header.find_property("x"),
+        header.find_property("y"),
+        header.find_property("z"),
+        header.find_property("red") ? header.find_property("red") : header.find_property("r"),
+        header.find_property("green") ? header.find_property("green") : header.find_property("g"),
+        header.find_property("blue") ? header.find_property("blue") : header.find_property("b")
+    };
+    if (!fields[0] || !fields[1] || !fields[2]) {
+        std::cerr << "Error: PLY vertices have no x, y, z properties" << std::endl;
+        return {};
+    }
+    if (header.vertex_count * header.vertex_stride > size) {
+        std::cerr << "Error: PLY file is shorter than its header describes" << std::endl;
+        return {};
+    }
+
+    std::vector<vertex> vertices(header.vertex_count);
+
+    const uint16_t endian_probe = 1;
+    const bool is_host_little_endian = *reinterpret_cast<const uint8_t*>(&endian_probe) == 1;
+    const bool swap_bytes = is_host_little_endian != (header.format == ply_binary_little_endian);
+
+    // records of six floats, position then color, are copied without decoding the fields
+    bool is_vertex_layout = !swap_bytes && header.vertex_stride == 6 * sizeof(float);
+    for (int f = 0; f < 6 && is_vertex_layout; ++f) {
+        is_vertex_layout = fields[f] && fields[f]->type == ply_float32 && fields[f]->offset == f * sizeof(float);
+    }
+
+    if (is_vertex_layout) {
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const char* record = data + i * header.vertex_stride;
+            std::memcpy(&vertices[i].position[0], record, 3 * sizeof(float));
+            std::memcpy(&vertices[i].color[0], record + 3 * sizeof(float), 3 * sizeof(float));
+        }
+    } else if (swap_bytes) {
+        decode_ply_vertices<true>(data, header, fields, vertices);
+    } else {
+        decode_ply_vertices<false>(data, header, fields, vertices);
+    }
+    return vertices;
+}
+
 std::vector<file_loader::vertex> file_loader::load_ply_file(const std::string& filename) {
-    std::ifstream file(filename);
+    const mapped_file mapped(filename);
+    if (!mapped.is_open()) {
+        return {};
+    }
+
+    ply_header header;
+    if (!parse_ply_header(mapped.begin(), mapped.end(), header)) {
+        return {};
+    }
+
+    if (header.format != ply_ascii) {
+        const size_t vertex_offset = header.data_offset + header.vertex_data_offset;
+        if (vertex_offset > mapped.size()) {
+            std::cerr << "Error: PLY file is shorter than its header describes" << std::endl;
+            return {};
+        }
+        return read_binary_ply_vertices(mapped.data() + vertex_offset, mapped.size() - vertex_offset, header);
+    }
+
+    std::ifstream file(filename, std::ios::binary);
     if (!file) {
         std::cerr << "Could not open file: " << filename << std::endl;
         return {};
     }
+    file.seekg(header.data_offset, std::ios::beg);
 
-    std::string line;
-    int num_vertices = 0;
-    bool header_finished = false;
-    while (std::getline(file, line)) {
-        if (line == "end_header") {
-            header_finished = true;
-            break;
-        }
+    return read_vertices_from_file(&file, (int)header.vertex_count);
+}
+
+template <typename T>
+static T read_las_value(const char* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
 
-        if (line.find("element vertex") == 0) {
-            std::sscanf(line.c_str(), "element vertex %d", &num_vertices);
+// offset of the rgb triplet inside a point record, -1 for the formats without color
+static int get_las_rgb_offset(const uint8_t point_format) {
+    switch (point_format) {
+    case 2:
+        return 20;
+    case 3:
+    case 5:
+        return 28;
+    case 7:
+    case 8:
+    case 10:
+        return 30;
+    default:
+        return -1;
+    }
+}
+
+bool file_loader::las_header::has_colors() const {
+    return get_las_rgb_offset(point_format) >= 0;
+}
+
+static size_t get_las_min_record_length(const uint8_t point_format) {
+    static constexpr size_t lengths[] = {20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67};
+    return lengths[point_format];
+}
+
+bool file_loader::parse_las_header(const char* data, const size_t size, las_header& header) {
+    if (size < 227 || std::memcmp(data, "LASF", 4) != 0) {
+        std::cerr << "Error: not a LAS file" << std::endl;
+        return false;
+    }
+    header.version_major = read_las_value<uint8_t>(data + 24);
+    header.version_minor = read_las_value<uint8_t>(data + 25);
+    header.header_size = read_las_value<uint16_t>(data + 94);
+    header.point_data_offset = read_las_value<uint32_t>(data + 96);
+    const uint8_t point_format = read_las_value<uint8_t>(data + 104);
+    header.point_record_length = read_las_value<uint16_t>(data + 105);
+    header.point_count = read_las_value<uint32_t>(data + 107);
+    for (int i = 0; i < 3; ++i) {
+        header.scale[i] = read_las_value<double>(data + 131 + i * 8);
+        header.offset[i] = read_las_value<double>(data + 155 + i * 8);
+        header.max[i] = read_las_value<double>(data + 179 + i * 16);
+        header.min[i] = read_las_value<double>(data + 187 + i * 16);
+    }
+    // LAS 1.4 keeps the legacy 32 bit count at zero for files with more points or the newer formats
+    if (header.version_major == 1 && header.version_minor >= 4 && header.header_size >= 375 && size >= 375) {
+        const uint64_t point_count = read_las_value<uint64_t>(data + 247);
+        if (point_count != 0) {
+            header.point_count = point_count;
         }
     }
 
-    if (!header_finished) {
-        std::cerr << "Error: Could not find end_header in PLY file" << std::endl;
+    if (header.version_major != 1 || header.version_minor > 4) {
+        std::cerr << "Error: unsupported LAS version " << (int)header.version_major << "." << (int)header.version_minor << std::endl;
+        return false;
+    }
+    if (point_format & 0x80) {
+        std::cerr << "Error: compressed LAZ point records are not supported" << std::endl;
+        return false;
+    }
+    header.point_format = point_format & 0x3f;
+    if (header.point_format > 10) {
+        std::cerr << "Error: unsupported LAS point format " << (int)header.point_format << std::endl;
+        return false;
+    }
+    if (header.point_record_length < get_las_min_record_length(header.point_format)) {
+        std::cerr << "Error: LAS point records are shorter than point format " << (int)header.point_format << std::endl;
+        return false;
+    }
+    if (header.point_data_offset > size || (size - header.point_data_offset) / header.point_record_length < header.point_count) {
+        std::cerr << "Error: LAS file is shorter than its header describes" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<file_loader::vertex> file_loader::load_las_file(const std::string& filename, las_header* header) {
+    const mapped_file mapped(filename);
+    if (!mapped.is_open()) {
         return {};
     }
 
-    return read_vertices_from_file(&file, num_vertices);
+    las_header las;
+    if (!parse_las_header(mapped.data(), mapped.size(), las)) {
+        return {};
+    }
+    if (header != nullptr) {
+        *header = las;
+    }
+
+    std::vector<vertex> vertices(las.point_count);
+    const char* records = mapped.data() + las.point_data_offset;
+    const size_t stride = las.point_record_length;
+    const int rgb_offset = get_las_rgb_offset(las.point_format);
+
+    uint16_t max_channel = 0;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const char* record = records + i * stride;
+        int32_t xyz[3];
+        std::memcpy(xyz, record, sizeof(xyz));
+        // the scaled coordinates are summed in double, survey offsets are too large for float on their own
+        vertices[i].position = glm::vec3(
+            (float)(xyz[0] * las.scale[0] + las.offset[0]),
+            (float)(xyz[1] * las.scale[1] + las.offset[1]),
+            (float)(xyz[2] * las.scale[2] + las.offset[2]));
+        // every point format has the intensity right after the coordinates
+        vertices[i].intensity = (float)read_las_value<uint16_t>(record + 12);
+        if (rgb_offset >= 0) {
+            uint16_t rgb[3];
+            std::memcpy(rgb, record + rgb_offset, sizeof(rgb));
+            max_channel = std::max({max_channel, rgb[0], rgb[1], rgb[2]});
+            vertices[i].color = glm::vec3(rgb[0], rgb[1], rgb[2]);
+        } else {
+            vertices[i].color = glm::vec3(vertices[i].intensity);
+        }
+    }
+
+    // the spec asks for 16 bit colors but plenty of writers store 8 bit values
+    if (rgb_offset >= 0) {
+        const float color_scale = max_channel > 255 ? 1.0f / 65535.0f : 1.0f / 255.0f;
+        for (auto& vertex : vertices) {
+            vertex.color *= color_scale;
+        }
+    }
+    return vertices;
 }
 
+bool file_loader::write_las_file(const std::string& filename, const std::vector<vertex>& vertices, const double scale) {
+    constexpr uint16_t header_size = 227;
+    constexpr uint16_t record_length = 26;
+
+    double min[3] = {0.0, 0.0, 0.0};
+    double max[3] = {0.0, 0.0, 0.0};
+    if (!vertices.empty()) {
+        for (int axis = 0; axis < 3; ++axis) {
+            min[axis] = max[axis] = vertices[0].position[axis];
+        }
+    }
+    for (const auto& vertex : vertices) {
+        for (int axis = 0; axis < 3; ++axis) {
+            min[axis] = std::min(min[axis], (double)vertex.position[axis]);
+            max[axis] = std::max(max[axis], (double)vertex.position[axis]);
+        }
+    }
+    if ((max[0] - min[0]) / scale > INT32_MAX || (max[1] - min[1]) / scale > INT32_MAX || (max[2] - min[2]) / scale > INT32_MAX) {
+        std::cerr << "Error: the cloud is too large for a LAS scale of " << scale << std::endl;
+        return false;
+    }
+
+    // written next to the final path and renamed, so a crash never leaves a truncated file behind
+    const std::string temporary_path = filename + ".tmp";
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "Could not open file: " << temporary_path << std::endl;
+        return false;
+    }
+
+    char header[header_size] = {};
+    auto put = [&header](const size_t offset, const auto value) {
+        std::memcpy(header + offset, &value, sizeof(value));
+    };
+    std::memcpy(header, "LASF", 4);
+    put(24, (uint8_t)1);
+    put(25, (uint8_t)2);
+    std::memcpy(header + 26, "SurfaceReconstruction", 21);
+    std::memcpy(header + 58, "SurfaceReconstruction", 21);
+    put(94, header_size);
+    put(96, (uint32_t)header_size);
+    put(100, (uint32_t)0);
+    put(104, (uint8_t)2);
+    put(105, record_length);
+    put(107, (uint32_t)vertices.size());
+    put(111, (uint32_t)vertices.size());
+    for (int axis = 0; axis < 3; ++axis) {
+        put(131 + axis * 8, scale);
+        put(155 + axis * 8, min[axis]);
+        put(179 + axis * 16, max[axis]);
+        put(187 + axis * 16, min[axis]);
+    }
+    file.write(header, header_size);
+
+    // records are encoded into a large buffer so the stream sees a few big writes
+    constexpr size_t records_per_chunk = 65536;
+    std::vector<char> chunk(records_per_chunk * record_length);
+    for (size_t first = 0; first < vertices.size(); first += records_per_chunk) {
+        const size_t count = std::min(records_per_chunk, vertices.size() - first);
+        std::fill(chunk.begin(), chunk.begin() + count * record_length, 0);
+        for (size_t i = 0; i < count; ++i) {
+            const vertex& vertex = vertices[first + i];
+            char* record = chunk.data() + i * record_length;
+            int32_t xyz[3];
+            uint16_t rgb[3];
+            for (int axis = 0; axis < 3; ++axis) {
+                xyz[axis] = (int32_t)std::llround((vertex.position[axis] - min[axis]) / scale);
+                rgb[axis] = (uint16_t)std::lround(std::clamp(vertex.color[axis], 0.0f, 1.0f) * 65535.0f);
+            }
+            const uint16_t intensity = (uint16_t)std::lround(std::clamp(vertex.intensity, 0.0f, 65535.0f));
+            std::memcpy(record, xyz, sizeof(xyz));
+            std::memcpy(record + 12, &intensity, sizeof(intensity));
+            // single return
+            record[14] = 0x09;
+            std::memcpy(record + 20, rgb, sizeof(rgb));
+        }
+        file.write(chunk.data(), count * record_length);
+    }
+    file.close();
+
+    std::error_code error;
+    if (!file) {
+        std::cerr << "Could not write LAS file: " << temporary_path << std::endl;
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+    std::filesystem::rename(temporary_path, filename, error);
+    if (error) {
+        std::cerr << "Could not move LAS file to " << filename << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+    return true;
+}
+
+template <typename Sensor>
 std::vector<file_loader::vertex> file_loader::load_xyz_file(const std::string& filename) {
     std::ifstream file(filename);
     if (!file) {
@@ -102,43 +642,306 @@ std::vector<file_loader::vertex> file_loader::load_xyz_file(const std::string& f
         return {};
     }
 
-    const int num_vertices = std::count(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>(), '\n');
-
-    file.seekg(0, std::ios::beg);
+    std::vector<vertex> vertices;
+    size_t record_index = 0;
+    vertex record{};
+    while (file >> record.position.x >> record.position.y >> record.position.z
+        >> record.color.r >> record.color.g >> record.color.b) {
+        record.intensity = record.color.r;
+        store_ring_ordered<Sensor>(vertices, record_index++, record);
+    }
+    finish_ring_order<Sensor>(vertices, record_index);
 
-    auto vertices = read_vertices_from_file(&file, num_vertices);
+    return vertices;
+}
 
-    bool delete_next = false;
-    for (auto it = vertices.begin(); it != vertices.end();) {
-        if (delete_next /*|| it->position == glm::vec3(0, 0, 0)*/) {
-            it = vertices.erase(it);
-        } else {
+const char* file_loader::parse_xyz_record(const char* it, const char* end, vertex& record) {
+    float* fields[6] = {
+        &record.position.x, &record.position.y, &record.position.z,
+        &record.color.r, &record.color.g, &record.color.b
+    };
+    for (float* field : fields) {
+        while (it != end && (*it == ' ' || *it == '\t' || *it == '\r' || *it == '\n')) {
+            ++it;
+        }
+        if (it != end && *it == '+') {
             ++it;
         }
-        delete_next = !delete_next;
-    }
-
-    const int reorder_indices[192] = {
-        11, 35, 59, 83, 107, 131, 155, 179, 23, 47, 71, 95, 119, 143, 167, 191,
-        10, 34, 58, 82, 106, 130, 154, 178, 22, 46, 70, 94, 118, 142, 166, 190,
-        9, 33, 57, 81, 105, 129, 153, 177, 21, 45, 69, 93, 117, 141, 165, 189,
-        8, 32, 56, 80, 104, 128, 152, 176, 20, 44, 68, 92, 116, 140, 164, 188,
-        7, 31, 55, 79, 103, 127, 151, 175, 19, 43, 67, 91, 115, 139, 163, 187,
-        6, 30, 54, 78, 102, 126, 150, 174, 18, 42, 66, 90, 114, 138, 162, 186,
-        5, 29, 53, 77, 101, 125, 149, 173, 17, 41, 65, 89, 113, 137, 161, 185,
-        4, 28, 52, 76, 100, 124, 148, 172, 16, 40, 64, 88, 112, 136, 160, 184,
-        3, 27, 51, 75, 99, 123, 147, 171, 15, 39, 63, 87, 111, 135, 159, 183,
-        2, 26, 50, 74, 98, 122, 146, 170, 14, 38, 62, 86, 110, 134, 158, 182,
-        1, 25, 49, 73, 97, 121, 145, 169, 13, 37, 61, 85, 109, 133, 157, 181,
-        0, 24, 48, 72, 96, 120, 144, 168, 12, 36, 60, 84, 108, 132, 156, 180
+        const auto [ptr, ec] = std::from_chars(it, end, *field);
+        if (ec != std::errc()) {
+            return nullptr;
+        }
+        it = ptr;
+    }
+    // the three color columns of the exported frames all hold the intensity
+    record.intensity = record.color.r;
+    return it;
+}
+
+template <typename Sensor>
+std::vector<file_loader::vertex> file_loader::parse_xyz_buffer(const char* begin, const char* end, size_t* record_count) {
+    // one xyz line is ~60 characters and every second one is kept, reserving a bit more avoids reallocation
+    std::vector<vertex> vertices;
+    vertices.reserve((end - begin) / 96 + Sensor::block_size);
+
+    const char* it = begin;
+    size_t record_index = 0;
+    vertex record{};
+    while ((it = parse_xyz_record(it, end, record)) != nullptr) {
+        store_ring_ordered<Sensor>(vertices, record_index++, record);
+    }
+    finish_ring_order<Sensor>(vertices, record_index);
+    if (record_count) {
+        *record_count = record_index;
+    }
+    return vertices;
+}
+
+template <typename Sensor>
+std::vector<file_loader::vertex> file_loader::load_xyz_file_mapped(const std::string& filename, load_statistics* statistics) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const mapped_file file(filename);
+    if (!file.is_open()) {
+        return {};
+    }
+
+    size_t record_count = 0;
+    std::vector<vertex> vertices = parse_xyz_buffer<Sensor>(file.begin(), file.end(), &record_count);
+
+    load_statistics load_stats;
+    load_stats.bytes = file.size();
+    load_stats.points = record_count;
+    load_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    std::cout << "Parsed " << load_stats.points << " points from " << filename << " in " << load_stats.seconds * 1000.0 << " ms ("
+        << load_stats.mb_per_second() << " MB/s, " << load_stats.points_per_second() << " points/s)" << std::endl;
+    if (statistics) {
+        *statistics = load_stats;
+    }
+
+    return vertices;
+}
+
+template <typename Sensor>
+point_cloud file_loader::parse_xyz_point_cloud(const char* begin, const char* end, size_t* record_count) {
+    point_cloud points;
+    points.reserve((end - begin) / 96 + Sensor::block_size);
+
+    const char* it = begin;
+    size_t record_index = 0;
+    vertex record{};
+    while ((it = parse_xyz_record(it, end, record)) != nullptr) {
+        store_ring_ordered<Sensor>(points, record_index++, record);
+    }
+    finish_ring_order<Sensor>(points, record_index);
+    if (record_count) {
+        *record_count = record_index;
+    }
+    return points;
+}
+
+template <typename Sensor>
+std::vector<file_loader::vertex> file_loader::load_xyz_file_parallel(const std::string& filename, size_t thread_count, load_statistics* statistics) {
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const mapped_file file(filename);
+    if (!file.is_open()) {
+        return {};
+    }
+
+    // threads only pay off with a few megabytes of text each, single frames stay on one thread
+    constexpr size_t min_chunk_size = 4 * 1024 * 1024;
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    thread_count = std::max<size_t>(1, std::min(thread_count, file.size() / min_chunk_size));
+
+    struct chunk {
+        const char* begin;
+        const char* end;
+        std::vector<vertex> records;
+        bool is_complete = true;
+        size_t first_record_index = 0;
+    };
+
+    // chunk borders are moved forward to the next line start so that no record is split
+    std::vector<chunk> chunks(thread_count);
+    const char* chunk_begin = file.begin();
+    for (size_t i = 0; i < thread_count; ++i) {
+        const char* chunk_end = i + 1 == thread_count ? file.end() : file.begin() + file.size() * (i + 1) / thread_count;
+        if (chunk_end < chunk_begin) {
+            chunk_end = chunk_begin;
+        }
+        if (chunk_end != file.end()) {
+            const void* newline = std::memchr(chunk_end, '\n', file.end() - chunk_end);
+            chunk_end = newline ? static_cast<const char*>(newline) + 1 : file.end();
+        }
+        chunks[i].begin = chunk_begin;
+        chunks[i].end = chunk_end;
+        chunk_begin = chunk_end;
+    }
+
+    auto parse_chunk = [](chunk& chunk) {
+        chunk.records.reserve((chunk.end - chunk.begin) / 48 + 1);
+        const char* it = chunk.begin;
+        const char* last_end = chunk.begin;
+        vertex record{};
+        while ((it = parse_xyz_record(it, chunk.end, record)) != nullptr) {
+            chunk.records.push_back(record);
+            last_end = it;
+        }
+        // the serial loader stops at the first malformed record, so everything after it has to be ignored
+        chunk.is_complete = std::all_of(last_end, chunk.end, [](const char c) {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        });
     };
 
-    std::vector<vertex> reordered_vertices = std::vector<vertex>(vertices.size());
-    for (int i = 0; i < vertices.size(); ++i) {
-        reordered_vertices[i] = vertices[reorder_indices[i % 192] + (i / 192) * 192];
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(parse_chunk, std::ref(chunks[i]));
+    }
+    parse_chunk(chunks[0]);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+
+    size_t record_count = 0;
+    size_t used_chunk_count = 0;
+    for (auto& chunk : chunks) {
+        chunk.first_record_index = record_count;
+        record_count += chunk.records.size();
+        ++used_chunk_count;
+        if (!chunk.is_complete) {
+            break;
+        }
+    }
+
+    // every kept record has a fixed final slot, so the chunks can be stitched in parallel as well
+    const size_t kept_count = (record_count + 1) / 2;
+    std::vector<vertex> vertices((kept_count + Sensor::block_size - 1) / Sensor::block_size * Sensor::block_size);
+    auto scatter_chunk = [&vertices](const chunk& chunk) {
+        for (size_t i = 0; i < chunk.records.size(); ++i) {
+            const size_t record_index = chunk.first_record_index + i;
+            if (record_index % 2 == 0) {
+                vertices[get_ring_order_slot<Sensor>(record_index / 2)] = chunk.records[i];
+            }
+        }
+    };
+    for (size_t i = 1; i < used_chunk_count; ++i) {
+        threads.emplace_back(scatter_chunk, std::cref(chunks[i]));
+    }
+    scatter_chunk(chunks[0]);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    finish_ring_order<Sensor>(vertices, record_count);
+
+    load_statistics load_stats;
+    load_stats.bytes = file.size();
+    load_stats.points = record_count;
+    load_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    std::cout << "Parsed " << load_stats.points << " points from " << filename << " on " << thread_count << " threads in "
+        << load_stats.seconds * 1000.0 << " ms (" << load_stats.mb_per_second() << " MB/s, " << load_stats.points_per_second() << " points/s)" << std::endl;
+    if (statistics) {
+        *statistics = load_stats;
+    }
+
+    return vertices;
+}
+
+// the table the exported VLP-16 frames were originally reordered with, the generated permutation has to match it
+static constexpr int vlp16_export_reorder_indices[vlp16_sensor::block_size] = {
+    11, 35, 59, 83, 107, 131, 155, 179, 23, 47, 71, 95, 119, 143, 167, 191,
+    10, 34, 58, 82, 106, 130, 154, 178, 22, 46, 70, 94, 118, 142, 166, 190,
+    9, 33, 57, 81, 105, 129, 153, 177, 21, 45, 69, 93, 117, 141, 165, 189,
+    8, 32, 56, 80, 104, 128, 152, 176, 20, 44, 68, 92, 116, 140, 164, 188,
+    7, 31, 55, 79, 103, 127, 151, 175, 19, 43, 67, 91, 115, 139, 163, 187,
+    6, 30, 54, 78, 102, 126, 150, 174, 18, 42, 66, 90, 114, 138, 162, 186,
+    5, 29, 53, 77, 101, 125, 149, 173, 17, 41, 65, 89, 113, 137, 161, 185,
+    4, 28, 52, 76, 100, 124, 148, 172, 16, 40, 64, 88, 112, 136, 160, 184,
+    3, 27, 51, 75, 99, 123, 147, 171, 15, 39, 63, 87, 111, 135, 159, 183,
+    2, 26, 50, 74, 98, 122, 146, 170, 14, 38, 62, 86, 110, 134, 158, 182,
+    1, 25, 49, 73, 97, 121, 145, 169, 13, 37, 61, 85, 109, 133, 157, 181,
+    0, 24, 48, 72, 96, 120, 144, 168, 12, 36, 60, 84, 108, 132, 156, 180
+};
+
+static constexpr bool is_vlp16_export_layout() {
+    for (int i = 0; i < vlp16_sensor::block_size; ++i) {
+        if (lidar_frame_layout<vlp16_sensor>::reorder_indices[i] != vlp16_export_reorder_indices[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(is_vlp16_export_layout(), "VLP-16 reorder table differs from the exported frame layout");
+
+// the sensor writes every return twice, only every second record is kept and placed into its ring ordered slot
+template <typename Sensor>
+void file_loader::store_ring_ordered(std::vector<vertex>& vertices, const size_t record_index, const vertex& record) {
+    if (record_index % 2 == 1) {
+        return;
+    }
+
+    const size_t kept_index = record_index / 2;
+    const size_t block_start = kept_index - kept_index % Sensor::block_size;
+    if (vertices.size() < block_start + Sensor::block_size) {
+        vertices.resize(block_start + Sensor::block_size);
     }
+    vertices[get_ring_order_slot<Sensor>(kept_index)] = record;
+}
+
+template <typename Sensor>
+size_t file_loader::get_ring_order_slot(const size_t kept_index) {
+    return kept_index - kept_index % Sensor::block_size + lidar_frame_layout<Sensor>::ring_order_slots[kept_index % Sensor::block_size];
+}
 
-    return reordered_vertices;
+template <typename Sensor>
+void file_loader::finish_ring_order(std::vector<vertex>& vertices, const size_t record_count) {
+    const size_t kept_count = (record_count + 1) / 2;
+    const size_t tail_count = kept_count % Sensor::block_size;
+    if (tail_count != 0) {
+        // an incomplete last block can not be reordered, its points are kept in file order
+        const size_t block_start = kept_count - tail_count;
+        std::array<vertex, Sensor::block_size> tail;
+        for (size_t i = 0; i < tail_count; ++i) {
+            tail[i] = vertices[block_start + lidar_frame_layout<Sensor>::ring_order_slots[i]];
+        }
+        std::copy(tail.begin(), tail.begin() + tail_count, vertices.begin() + block_start);
+    }
+    vertices.resize(kept_count);
+}
+
+template <typename Sensor>
+void file_loader::store_ring_ordered(point_cloud& points, const size_t record_index, const vertex& record) {
+    if (record_index % 2 == 1) {
+        return;
+    }
+
+    const size_t kept_index = record_index / 2;
+    const size_t block_start = kept_index - kept_index % Sensor::block_size;
+    if (points.size() < block_start + Sensor::block_size) {
+        points.resize(block_start + Sensor::block_size);
+    }
+    points.set_vertex(get_ring_order_slot<Sensor>(kept_index), record);
+}
+
+template <typename Sensor>
+void file_loader::finish_ring_order(point_cloud& points, const size_t record_count) {
+    const size_t kept_count = (record_count + 1) / 2;
+    const size_t tail_count = kept_count % Sensor::block_size;
+    if (tail_count != 0) {
+        const size_t block_start = kept_count - tail_count;
+        std::array<vertex, Sensor::block_size> tail;
+        for (size_t i = 0; i < tail_count; ++i) {
+            tail[i] = points.get_vertex(block_start + lidar_frame_layout<Sensor>::ring_order_slots[i]);
+        }
+        for (size_t i = 0; i < tail_count; ++i) {
+            points.set_vertex(block_start + i, tail[i]);
+        }
+    }
+    points.resize(kept_count);
 }
 
 std::vector<std::string> file_loader::get_directory_files(const std::string& folder_name) {
@@ -148,3 +951,28 @@ std::vector<std::string> file_loader::get_directory_files(const std::string& fol
     }
     return file_paths;
 }
+
+bool file_loader::has_extension(const std::string& path, const char* extension) {
+    std::string path_extension = std::filesystem::path(path).extension().string();
+    for (char& c : path_extension) {
+        c = (char)std::tolower((unsigned char)c);
+    }
+    return path_extension == extension;
+}
+
+void file_loader::normalize_intensities(std::vector<vertex>& vertices) {
+    for (vertex& vertex : vertices) {
+        vertex.color /= 255.0f;
+    }
+}
+
+#define INSTANTIATE_XYZ_LOADERS(Sensor) \
+    template std::vector<file_loader::vertex> file_loader::load_xyz_file<Sensor>(const std::string&); \
+    template std::vector<file_loader::vertex> file_loader::load_xyz_file_mapped<Sensor>(const std::string&, load_statistics*); \
+    template std::vector<file_loader::vertex> file_loader::parse_xyz_buffer<Sensor>(const char*, const char*, size_t*); \
+    template std::vector<file_loader::vertex> file_loader::load_xyz_file_parallel<Sensor>(const std::string&, size_t, load_statistics*); \
+    template point_cloud file_loader::parse_xyz_point_cloud<Sensor>(const char*, const char*, size_t*);
+
+INSTANTIATE_XYZ_LOADERS(vlp16_sensor)
+INSTANTIATE_XYZ_LOADERS(vlp32_sensor)
+INSTANTIATE_XYZ_LOADERS(hdl64_sensor)
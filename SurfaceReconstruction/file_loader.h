@@ -1,16 +1,30 @@
 ﻿#pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <glm/glm.hpp>
+#include "lidar_sensor_model.h"
 #include <vector>
 #include <random>
 #include <string>
 
+class point_cloud;
+
 class file_loader {
 public:
     struct vertex {
         glm::vec3 position;
+        // the file or camera rgb where there is one, the loaders without colors put the intensity in all three channels
         glm::vec3 color;
+        // the raw return strength in the units of the source: 0 - 255 for the VLP-16, 16 bits for las
+        float intensity = 0.0f;
+    };
+
+    struct image {
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        std::vector<uint8_t> pixels;
     };
 
     struct digital_camera_internal_params {
@@ -36,9 +50,120 @@ public:
         }
     };
 
+    struct load_statistics {
+        size_t bytes = 0;
+        size_t points = 0;
+        double seconds = 0.0;
+
+        double mb_per_second() const {
+            return seconds > 0.0 ? (double)bytes / (1024.0 * 1024.0) / seconds : 0.0;
+        }
+
+        double points_per_second() const {
+            return seconds > 0.0 ? (double)points / seconds : 0.0;
+        }
+    };
+
+    enum ply_format {
+        ply_ascii = 0,
+        ply_binary_little_endian = 1,
+        ply_binary_big_endian = 2
+    };
+
+    enum ply_scalar_type {
+        ply_int8 = 0,
+        ply_uint8 = 1,
+        ply_int16 = 2,
+        ply_uint16 = 3,
+        ply_int32 = 4,
+        ply_uint32 = 5,
+        ply_float32 = 6,
+        ply_float64 = 7
+    };
+
+    struct ply_property {
+        std::string name;
+        ply_scalar_type type;
+        size_t offset;
+    };
+
+    struct ply_header {
+        ply_format format = ply_ascii;
+        size_t vertex_count = 0;
+        size_t vertex_stride = 0;
+        size_t data_offset = 0;
+        size_t vertex_data_offset = 0;
+        std::vector<ply_property> vertex_properties;
+
+        const ply_property* find_property(const std::string& name) const {
+            for (const auto& property : vertex_properties) {
+                if (property.name == name) {
+                    return &property;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    // public header block of a LAS 1.0 - 1.4 file, only the fields needed to decode the point records
+    struct las_header {
+        uint8_t version_major = 1;
+        uint8_t version_minor = 2;
+        uint16_t header_size = 0;
+        uint32_t point_data_offset = 0;
+        uint8_t point_format = 0;
+        uint16_t point_record_length = 0;
+        uint64_t point_count = 0;
+        double scale[3] = {0.001, 0.001, 0.001};
+        double offset[3] = {0.0, 0.0, 0.0};
+        double min[3] = {0.0, 0.0, 0.0};
+        double max[3] = {0.0, 0.0, 0.0};
+
+        // the point formats with an rgb triplet
+        bool has_colors() const;
+    };
+
     static digital_camera_params load_digital_camera_params(const std::string& filename);
+    static digital_camera_params load_digital_camera_params_json(const std::string& filename);
     static std::vector<vertex> read_vertices_from_file(std::ifstream* file, int vertex_count);
     static std::vector<vertex> load_ply_file(const std::string& filename);
+    static bool parse_ply_header(const char* begin, const char* end, ply_header& header);
+    static std::vector<vertex> read_binary_ply_vertices(const char* data, size_t size, const ply_header& header);
+    static bool parse_las_header(const char* data, size_t size, las_header& header);
+    // positions are scale * record + offset, rgb formats give colors in [0, 1], the others the raw intensity like the xyz files.
+    // The intensity field is the raw intensity of every format.
+    static std::vector<vertex> load_las_file(const std::string& filename, las_header* header = nullptr);
+    // writes a LAS 1.2 file with point format 2, colors in [0, 1] are stored as 16 bit rgb next to the intensity
+    static bool write_las_file(const std::string& filename, const std::vector<vertex>& vertices, double scale = 0.001);
+    // the xyz loaders reorder the points into rings as laid out by the sensor model, instantiated for the models in lidar_sensor_model.h
+    template <typename Sensor = active_sensor_model>
     static std::vector<vertex> load_xyz_file(const std::string& filename);
+    template <typename Sensor = active_sensor_model>
+    static std::vector<vertex> load_xyz_file_mapped(const std::string& filename, load_statistics* statistics = nullptr);
+    template <typename Sensor = active_sensor_model>
+    static std::vector<vertex> parse_xyz_buffer(const char* begin, const char* end, size_t* record_count = nullptr);
+    template <typename Sensor = active_sensor_model>
+    static std::vector<vertex> load_xyz_file_parallel(const std::string& filename, size_t thread_count = 0, load_statistics* statistics = nullptr);
+    // the same ring ordered points as a point_cloud of positions and intensities (the fourth column), without colors
+    template <typename Sensor = active_sensor_model>
+    static point_cloud parse_xyz_point_cloud(const char* begin, const char* end, size_t* record_count = nullptr);
+    static const char* parse_xyz_record(const char* it, const char* end, vertex& record);
     static std::vector<std::string> get_directory_files(const std::string& folder_name);
+    // extension is lower case with the dot, the one of path is compared ignoring case
+    static bool has_extension(const std::string& path, const char* extension);
+    // the xyz, archive and pcap loaders color with the raw 0 - 255 intensities, scaled to 0 - 1 like the las colors.
+    // The intensity field stays raw.
+    static void normalize_intensities(std::vector<vertex>& vertices);
+
+private:
+    template <typename Sensor>
+    static void store_ring_ordered(std::vector<vertex>& vertices, size_t record_index, const vertex& record);
+    template <typename Sensor>
+    static void finish_ring_order(std::vector<vertex>& vertices, size_t record_count);
+    template <typename Sensor>
+    static void store_ring_ordered(point_cloud& points, size_t record_index, const vertex& record);
+    template <typename Sensor>
+    static void finish_ring_order(point_cloud& points, size_t record_count);
+    template <typename Sensor>
+    static size_t get_ring_order_slot(size_t kept_index);
 };
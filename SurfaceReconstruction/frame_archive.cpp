@@ -0,0 +1,317 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include "frame_archive.h"
+#include "entropy_coder.h"
+#include "dataset_manifest.h"
+#include "frame_sequence_player.h"
+
+namespace {
+    constexpr int azimuth_steps = range_image::azimuth_steps;
+    constexpr size_t header_size = 24;
+    constexpr size_t index_entry_size = 20;
+
+    uint64_t zigzag(const int64_t value) {
+        return (uint64_t)(value << 1) ^ (uint64_t)(value >> 63);
+    }
+
+    int64_t unzigzag(const uint64_t value) {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    template <typename T>
+    void write(std::ofstream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    T read(const char* data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+}
+
+void frame_archive::encode_frame(const std::vector<file_loader::vertex>& vertices, const int beam_count, std::vector<uint8_t>& output) {
+    encode_frame(range_image::from_vertices(vertices, beam_count), output);
+}
+
+void frame_archive::encode_frame(const range_image& image, std::vector<uint8_t>& output) {
+    const int beam_count = image.get_beam_count();
+    const size_t column_count = image.get_column_count();
+
+    std::vector<uint8_t> azimuth_stream;
+    int previous_delta = 0;
+    for (size_t column = 0; column < column_count; ++column) {
+        const int delta = column == 0 ? image.get_column_azimuth(0) : range_image::wrap_azimuth_difference(image.get_column_azimuth(column) - image.get_column_azimuth(column - 1));
+        entropy_coder::write_varint(zigzag(delta - previous_delta), azimuth_stream);
+        previous_delta = column == 0 ? 0 : delta;
+    }
+
+    // ranges and intensities are laid out ring by ring like in the range image, so the deltas follow the scan line
+    const size_t cell_count = image.get_cell_count();
+    std::vector<uint8_t> azimuth_residuals(cell_count);
+    std::vector<uint8_t> range_stream;
+    std::vector<uint8_t> intensities(cell_count);
+    range_stream.reserve(cell_count * 2);
+    for (int ring = 0; ring < beam_count; ++ring) {
+        int64_t previous_range = 0;
+        for (size_t column = 0; column < column_count; ++column) {
+            const bool is_valid = image.is_valid(ring, column);
+            const int64_t range = is_valid ? std::llround(image.get_range(ring, column) / range_unit) : 0;
+            entropy_coder::write_varint(zigzag(range - previous_range), range_stream);
+            previous_range = range;
+            const size_t cell = image.get_cell_index(ring, column);
+            azimuth_residuals[cell] = is_valid ? (uint8_t)zigzag(image.get_azimuth_offset(ring, column)) : 0;
+            intensities[cell] = image.get_intensity(ring, column);
+        }
+    }
+
+    std::vector<float> ring_elevations(beam_count);
+    for (int ring = 0; ring < beam_count; ++ring) {
+        ring_elevations[ring] = image.get_elevation(ring);
+    }
+    entropy_coder::write_varint(beam_count, output);
+    entropy_coder::write_varint(column_count, output);
+    const size_t elevation_offset = output.size();
+    output.resize(elevation_offset + beam_count * sizeof(float));
+    std::memcpy(output.data() + elevation_offset, ring_elevations.data(), beam_count * sizeof(float));
+    entropy_coder::encode(azimuth_stream.data(), azimuth_stream.size(), output);
+    entropy_coder::encode(azimuth_residuals.data(), azimuth_residuals.size(), output);
+    entropy_coder::encode(range_stream.data(), range_stream.size(), output);
+    entropy_coder::encode(intensities.data(), intensities.size(), output);
+}
+
+bool frame_archive::decode_frame(const uint8_t* data, const size_t size, std::vector<file_loader::vertex>& vertices) {
+    range_image image;
+    if (!decode_frame(data, size, image)) {
+        return false;
+    }
+    image.to_vertices(vertices);
+    return true;
+}
+
+bool frame_archive::decode_frame(const uint8_t* data, const size_t size, range_image& image) {
+    const uint8_t* it = data;
+    const uint8_t* end = data + size;
+    uint64_t beam_count;
+    uint64_t column_count;
+    if (!entropy_coder::read_varint(it, end, beam_count) || !entropy_coder::read_varint(it, end, column_count) ||
+        beam_count == 0 || beam_count > 256 || (uint64_t)(end - it) < beam_count * sizeof(float)) {
+        return false;
+    }
+    const size_t cell_count = beam_count * column_count;
+    std::vector<float> ring_elevations(beam_count);
+    std::memcpy(ring_elevations.data(), it, beam_count * sizeof(float));
+    it += beam_count * sizeof(float);
+
+    std::vector<uint8_t> azimuth_stream;
+    std::vector<uint8_t> azimuth_residuals;
+    std::vector<uint8_t> range_stream;
+    std::vector<uint8_t> intensities;
+    if (!entropy_coder::decode(it, end, azimuth_stream) || !entropy_coder::decode(it, end, azimuth_residuals) ||
+        !entropy_coder::decode(it, end, range_stream) || !entropy_coder::decode(it, end, intensities) ||
+        azimuth_residuals.size() != cell_count || intensities.size() != cell_count) {
+        return false;
+    }
+
+    image = range_image((int)beam_count, column_count);
+    for (size_t ring = 0; ring < beam_count; ++ring) {
+        image.set_elevation((int)ring, ring_elevations[ring]);
+    }
+    const uint8_t* azimuth_it = azimuth_stream.data();
+    const uint8_t* azimuth_end = azimuth_it + azimuth_stream.size();
+    int azimuth = 0;
+    int delta = 0;
+    for (size_t column = 0; column < column_count; ++column) {
+        uint64_t value;
+        if (!entropy_coder::read_varint(azimuth_it, azimuth_end, value)) {
+            return false;
+        }
+        delta += (int)unzigzag(value);
+        azimuth = ((azimuth + delta) % azimuth_steps + azimuth_steps) % azimuth_steps;
+        if (column == 0) {
+            delta = 0;
+        }
+        image.set_column_azimuth(column, azimuth);
+    }
+
+    const uint8_t* range_it = range_stream.data();
+    const uint8_t* range_end = range_it + range_stream.size();
+    for (size_t ring = 0; ring < beam_count; ++ring) {
+        int64_t range = 0;
+        for (size_t column = 0; column < column_count; ++column) {
+            uint64_t value;
+            if (!entropy_coder::read_varint(range_it, range_end, value)) {
+                return false;
+            }
+            range += unzigzag(value);
+            const size_t cell = ring * column_count + column;
+            image.set_cell((int)ring, column, range > 0 ? range * range_unit : 0.0f, intensities[cell], (int8_t)unzigzag(azimuth_residuals[cell]));
+        }
+    }
+    return true;
+}
+
+bool frame_archive::is_archive_file(const std::string& path) {
+    return std::filesystem::path(path).extension() == ".srarc";
+}
+
+size_t frame_archive::convert_folder(const std::string& folder_name, const std::string& archive_path) {
+    const auto frames = frame_sequence_player::find_frames(folder_name);
+    frame_archive_writer writer;
+    if (!writer.open(archive_path)) {
+        return 0;
+    }
+
+    uint64_t source_bytes = 0;
+    for (const auto& frame : frames) {
+        const auto vertices = dataset_manifest::load_points(frame.points);
+        if (vertices.empty()) {
+            std::cerr << "Skipping frame fn" << frame.frame_number << std::endl;
+            continue;
+        }
+        std::error_code error;
+        source_bytes += frame.points.size != 0 ? frame.points.size : std::filesystem::file_size(frame.points.file, error) - frame.points.offset;
+        writer.add_frame(frame.frame_number, vertices);
+    }
+    const size_t frame_count = writer.get_frame_count();
+    const uint64_t archive_bytes = writer.get_written_bytes();
+    if (!writer.close()) {
+        return 0;
+    }
+    std::cout << "Archived " << frame_count << " frames to " << archive_path << ": " << archive_bytes << " bytes from "
+        << source_bytes << " bytes of xyz (" << (archive_bytes > 0 ? (double)source_bytes / archive_bytes : 0.0) << "x smaller)" << std::endl;
+    return frame_count;
+}
+
+frame_archive_writer::~frame_archive_writer() {
+    if (m_file.is_open()) {
+        close();
+    }
+}
+
+bool frame_archive_writer::open(const std::string& filename, const int beam_count) {
+    m_filename = filename;
+    m_beam_count = beam_count;
+    m_index.clear();
+    // written next to the final path and renamed in close, a reader never sees a half written archive
+    m_file.open(filename + ".tmp", std::ios::binary | std::ios::trunc);
+    if (!m_file) {
+        std::cerr << "Could not write frame archive: " << filename << ".tmp" << std::endl;
+        return false;
+    }
+    m_file.write(frame_archive::magic, sizeof(frame_archive::magic));
+    write(m_file, frame_archive::version);
+    write(m_file, (uint32_t)0);
+    write(m_file, (uint32_t)0);
+    write(m_file, (uint64_t)0);
+    m_offset = header_size;
+    return true;
+}
+
+bool frame_archive_writer::add_frame(const int frame_number, const std::vector<file_loader::vertex>& vertices) {
+    m_encoded.clear();
+    frame_archive::encode_frame(vertices, m_beam_count, m_encoded);
+    m_file.write(reinterpret_cast<const char*>(m_encoded.data()), m_encoded.size());
+
+    frame_archive::index_entry entry;
+    entry.offset = m_offset;
+    entry.size = (uint32_t)m_encoded.size();
+    entry.frame_number = frame_number;
+    entry.column_count = (uint32_t)(vertices.size() / m_beam_count);
+    m_index.push_back(entry);
+    m_offset += m_encoded.size();
+    return (bool)m_file;
+}
+
+bool frame_archive_writer::close() {
+    const uint64_t index_offset = m_offset;
+    for (const auto& entry : m_index) {
+        write(m_file, entry.offset);
+        write(m_file, entry.size);
+        write(m_file, entry.frame_number);
+        write(m_file, entry.column_count);
+    }
+    m_file.seekp(12);
+    write(m_file, (uint32_t)m_index.size());
+    write(m_file, index_offset);
+    const bool is_written = (bool)m_file;
+    m_file.close();
+
+    const std::string temporary_path = m_filename + ".tmp";
+    std::error_code error;
+    if (!is_written) {
+        std::cerr << "Could not write frame archive: " << temporary_path << std::endl;
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+    std::filesystem::rename(temporary_path, m_filename, error);
+    if (error) {
+        std::cerr << "Could not move frame archive to " << m_filename << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+    return true;
+}
+
+bool frame_archive_reader::open(const std::string& filename) {
+    close();
+    if (!m_file.open(filename)) {
+        std::cerr << "Could not open frame archive: " << filename << std::endl;
+        return false;
+    }
+    const char* data = m_file.data();
+    if (m_file.size() < header_size || std::memcmp(data, frame_archive::magic, sizeof(frame_archive::magic)) != 0 ||
+        read<uint32_t>(data + 4) != frame_archive::version) {
+        std::cerr << "Not a frame archive or unsupported version: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    const uint32_t frame_count = read<uint32_t>(data + 12);
+    const uint64_t index_offset = read<uint64_t>(data + 16);
+    if (index_offset > m_file.size() || (m_file.size() - index_offset) / index_entry_size < frame_count) {
+        std::cerr << "Truncated frame archive: " << filename << std::endl;
+        close();
+        return false;
+    }
+    m_index.resize(frame_count);
+    const char* entry_data = data + index_offset;
+    for (auto& entry : m_index) {
+        entry.offset = read<uint64_t>(entry_data);
+        entry.size = read<uint32_t>(entry_data + 8);
+        entry.frame_number = read<int32_t>(entry_data + 12);
+        entry.column_count = read<uint32_t>(entry_data + 16);
+        entry_data += index_entry_size;
+        if (entry.offset + entry.size > index_offset) {
+            std::cerr << "Corrupt frame archive index: " << filename << std::endl;
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void frame_archive_reader::close() {
+    m_file.close();
+    m_index.clear();
+}
+
+bool frame_archive_reader::read_frame(const size_t index, std::vector<file_loader::vertex>& vertices) const {
+    if (index >= m_index.size()) {
+        return false;
+    }
+    const auto& entry = m_index[index];
+    return frame_archive::decode_frame(reinterpret_cast<const uint8_t*>(m_file.data()) + entry.offset, entry.size, vertices);
+}
+
+bool frame_archive_reader::read_frame(const size_t index, range_image& image) const {
+    if (index >= m_index.size()) {
+        return false;
+    }
+    const auto& entry = m_index[index];
+    return frame_archive::decode_frame(reinterpret_cast<const uint8_t*>(m_file.data()) + entry.offset, entry.size, image);
+}
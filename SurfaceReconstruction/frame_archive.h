@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "file_loader.h"
+#include "mapped_file.h"
+#include "range_image.h"
+
+// compressed archive (.srarc) of ring ordered lidar frames. Every frame is stored as a beam_count x N range image:
+// one quantized azimuth per column, one elevation per ring, ranges quantized to a millimetre and delta coded along
+// each ring, intensities as bytes, all streams entropy coded. An index at the end of the file allows random access.
+class frame_archive {
+public:
+    static constexpr char magic[4] = {'S', 'R', 'F', 'A'};
+    static constexpr uint32_t version = 1;
+    static constexpr float range_unit = 0.001f;
+    static constexpr float azimuth_unit = range_image::azimuth_unit;
+
+    struct index_entry {
+        uint64_t offset = 0;
+        uint32_t size = 0;
+        int32_t frame_number = -1;
+        uint32_t column_count = 0;
+    };
+
+    // positions are reconstructed from range and direction, the color holds the intensity (clamped to 0 - 255)
+    static void encode_frame(const std::vector<file_loader::vertex>& vertices, int beam_count, std::vector<uint8_t>& output);
+    static bool decode_frame(const uint8_t* data, size_t size, std::vector<file_loader::vertex>& vertices);
+    // the archive stores frames as range images, these skip the conversion from and to points
+    static void encode_frame(const range_image& image, std::vector<uint8_t>& output);
+    static bool decode_frame(const uint8_t* data, size_t size, range_image& image);
+
+    // converts the fnNNN xyz frames of a recording folder, returns the number of archived frames
+    static size_t convert_folder(const std::string& folder_name, const std::string& archive_path);
+    static bool is_archive_file(const std::string& path);
+};
+
+class frame_archive_writer {
+public:
+    frame_archive_writer() = default;
+    ~frame_archive_writer();
+
+    frame_archive_writer(const frame_archive_writer&) = delete;
+    frame_archive_writer& operator=(const frame_archive_writer&) = delete;
+
+    bool open(const std::string& filename, int beam_count = active_sensor_model::beam_count);
+    bool add_frame(int frame_number, const std::vector<file_loader::vertex>& vertices);
+    // writes the index and moves the archive to its final name
+    bool close();
+
+    size_t get_frame_count() const { return m_index.size(); }
+    uint64_t get_written_bytes() const { return m_offset; }
+
+private:
+    std::string m_filename;
+    std::ofstream m_file;
+    int m_beam_count = 0;
+    uint64_t m_offset = 0;
+    std::vector<frame_archive::index_entry> m_index;
+    std::vector<uint8_t> m_encoded;
+};
+
+class frame_archive_reader {
+public:
+    bool open(const std::string& filename);
+    void close();
+    bool is_open() const { return m_file.is_open(); }
+
+    size_t get_frame_count() const { return m_index.size(); }
+    const frame_archive::index_entry& get_entry(size_t index) const { return m_index[index]; }
+    bool read_frame(size_t index, std::vector<file_loader::vertex>& vertices) const;
+    bool read_frame(size_t index, range_image& image) const;
+
+private:
+    mapped_file m_file;
+    std::vector<frame_archive::index_entry> m_index;
+};
@@ -0,0 +1,273 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+#include "frame_cache.h"
+#include "mapped_file.h"
+
+namespace {
+    class byte_reader {
+    public:
+        byte_reader(const char* begin, const char* end) : m_it(begin), m_end(end) {}
+
+        bool read_bytes(void* destination, const size_t size) {
+            if ((size_t)(m_end - m_it) < size) {
+                return false;
+            }
+            std::memcpy(destination, m_it, size);
+            m_it += size;
+            return true;
+        }
+
+        template <typename T>
+        bool read(T& value) {
+            return read_bytes(&value, sizeof(T));
+        }
+
+        const char* get_position() const { return m_it; }
+
+        bool read_string(std::string& value) {
+            uint32_t length;
+            if (!read(length) || (size_t)(m_end - m_it) < length) {
+                return false;
+            }
+            value.assign(m_it, length);
+            m_it += length;
+            return true;
+        }
+
+    private:
+        const char* m_it;
+        const char* m_end;
+    };
+
+    template <typename T>
+    void write(std::ostream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void write_string(std::ostream& file, const std::string& value) {
+        write(file, (uint32_t)value.size());
+        file.write(value.data(), value.size());
+    }
+}
+
+std::string frame_cache::get_cache_path(const std::string& folder_name, const int frame_number) {
+    std::string path = folder_name;
+    while (!path.empty() && (path.back() == '\\' || path.back() == '/')) {
+        path.pop_back();
+    }
+    return path + "_fn" + std::to_string(frame_number) + ".srbin";
+}
+
+bool frame_cache::get_source_stamp(const std::string& path, source_stamp& stamp) {
+    std::error_code error;
+    const auto size = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    const auto modification_time = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return false;
+    }
+    stamp.path = path;
+    stamp.size = size;
+    stamp.modification_time = modification_time.time_since_epoch().count();
+    return true;
+}
+
+uint64_t frame_cache::hash_sources(const std::vector<std::string>& sources) {
+    // 64 bit FNV-1a over the contents of all sources
+    uint64_t hash = 14695981039346656037ull;
+    for (const auto& source : sources) {
+        const mapped_file file(source);
+        for (const char c : file) {
+            hash ^= (uint8_t)c;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+bool frame_cache::load(const std::string& cache_path, const std::vector<std::string>& sources, frame& frame) {
+    std::vector<outdated_stamp> outdated_stamps;
+    if (!read(cache_path, sources, frame, outdated_stamps)) {
+        return false;
+    }
+    if (!outdated_stamps.empty()) {
+        refresh_stamps(cache_path, outdated_stamps);
+    }
+    return true;
+}
+
+bool frame_cache::read(const std::string& cache_path, const std::vector<std::string>& sources, frame& frame,
+                       std::vector<outdated_stamp>& outdated_stamps) {
+    std::error_code error;
+    if (!std::filesystem::exists(cache_path, error)) {
+        return false;
+    }
+
+    const mapped_file file(cache_path);
+    if (!file.is_open()) {
+        return false;
+    }
+    byte_reader reader(file.begin(), file.end());
+
+    char file_magic[4];
+    uint32_t file_version;
+    uint64_t content_hash;
+    uint32_t source_count;
+    if (!reader.read(file_magic) || std::memcmp(file_magic, magic, sizeof(magic)) != 0 ||
+        !reader.read(file_version) || file_version != version ||
+        !reader.read(content_hash) || !reader.read(source_count)) {
+        std::cout << "Ignoring outdated or invalid frame cache " << cache_path << std::endl;
+        return false;
+    }
+    if (source_count != sources.size()) {
+        return false;
+    }
+
+    // size and modification time are enough to accept the cache without reading the sources,
+    // the content hash decides when only the timestamps changed (e.g. after copying a dataset)
+    for (const auto& source : sources) {
+        source_stamp stored_stamp;
+        source_stamp current_stamp;
+        if (!reader.read_string(stored_stamp.path) || !reader.read(stored_stamp.size)) {
+            return false;
+        }
+        const size_t modification_time_offset = reader.get_position() - file.begin();
+        if (!reader.read(stored_stamp.modification_time) || !get_source_stamp(source, current_stamp)) {
+            return false;
+        }
+        if (stored_stamp.path != current_stamp.path || stored_stamp.size != current_stamp.size) {
+            return false;
+        }
+        if (stored_stamp.modification_time != current_stamp.modification_time) {
+            outdated_stamps.push_back({modification_time_offset, current_stamp.modification_time});
+        }
+    }
+    if (!outdated_stamps.empty() && hash_sources(sources) != content_hash) {
+        return false;
+    }
+
+    auto& internal_params = frame.camera_params.internal_params;
+    uint32_t device_count;
+    if (!reader.read(internal_params.fu) || !reader.read(internal_params.fv) ||
+        !reader.read(internal_params.u0) || !reader.read(internal_params.v0) || !reader.read(device_count)) {
+        return false;
+    }
+    frame.camera_params.devices.resize(device_count);
+    for (auto& device : frame.camera_params.devices) {
+        if (!reader.read_string(device.name) || !reader.read(device.r) || !reader.read(device.t)) {
+            return false;
+        }
+    }
+
+    uint32_t vertex_count;
+    if (!reader.read(vertex_count)) {
+        return false;
+    }
+    frame.vertices.resize(vertex_count);
+    if (!reader.read_bytes(frame.vertices.data(), vertex_count * sizeof(file_loader::vertex))) {
+        return false;
+    }
+
+    uint32_t image_count;
+    if (!reader.read(image_count)) {
+        return false;
+    }
+    frame.images.resize(image_count);
+    for (auto& image : frame.images) {
+        if (!reader.read(image.width) || !reader.read(image.height) || !reader.read(image.channels)) {
+            return false;
+        }
+        image.pixels.resize((size_t)image.width * image.height * image.channels);
+        if (!reader.read_bytes(image.pixels.data(), image.pixels.size())) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void frame_cache::refresh_stamps(const std::string& cache_path, const std::vector<outdated_stamp>& outdated_stamps) {
+    // the content is unchanged, the new times let the next load skip the hash
+    std::fstream file(cache_path, std::ios::binary | std::ios::in | std::ios::out);
+    for (const auto& [offset, modification_time] : outdated_stamps) {
+        file.seekp((std::streamoff)offset);
+        write(file, modification_time);
+    }
+    if (!file) {
+        std::cerr << "Could not refresh the source times of frame cache: " << cache_path << std::endl;
+    }
+}
+
+bool frame_cache::save(const std::string& cache_path, const std::vector<std::string>& sources, const frame& frame) {
+    std::vector<source_stamp> stamps(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!get_source_stamp(sources[i], stamps[i])) {
+            std::cerr << "Could not stat cache source: " << sources[i] << std::endl;
+            return false;
+        }
+    }
+
+    // written next to the final path and renamed, so a crash never leaves a truncated cache behind
+    const std::string temporary_path = cache_path + ".tmp";
+    std::error_code error;
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Could not write frame cache: " << temporary_path << std::endl;
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+
+        file.write(magic, sizeof(magic));
+        write(file, version);
+        write(file, hash_sources(sources));
+        write(file, (uint32_t)sources.size());
+        for (const auto& stamp : stamps) {
+            write_string(file, stamp.path);
+            write(file, stamp.size);
+            write(file, stamp.modification_time);
+        }
+
+        const auto& internal_params = frame.camera_params.internal_params;
+        write(file, internal_params.fu);
+        write(file, internal_params.fv);
+        write(file, internal_params.u0);
+        write(file, internal_params.v0);
+        write(file, (uint32_t)frame.camera_params.devices.size());
+        for (const auto& device : frame.camera_params.devices) {
+            write_string(file, device.name);
+            write(file, device.r);
+            write(file, device.t);
+        }
+
+        write(file, (uint32_t)frame.vertices.size());
+        file.write(reinterpret_cast<const char*>(frame.vertices.data()), frame.vertices.size() * sizeof(file_loader::vertex));
+
+        write(file, (uint32_t)frame.images.size());
+        for (const auto& image : frame.images) {
+            write(file, image.width);
+            write(file, image.height);
+            write(file, image.channels);
+            file.write(reinterpret_cast<const char*>(image.pixels.data()), image.pixels.size());
+        }
+
+        file.close();
+        if (!file) {
+            std::cerr << "Could not write frame cache: " << temporary_path << std::endl;
+            std::filesystem::remove(temporary_path, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary_path, cache_path, error);
+    if (error) {
+        std::cerr << "Could not move frame cache to " << cache_path << ": " << error.message() << std::endl;
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+    return true;
+}
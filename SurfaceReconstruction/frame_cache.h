@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "file_loader.h"
+
+// versioned binary cache (.srbin) of a fully prepared input frame: the ring ordered points,
+// the digital camera parameters and the decoded camera images
+class frame_cache {
+public:
+    static constexpr char magic[4] = {'S', 'R', 'B', 'N'};
+    static constexpr uint32_t version = 2;
+
+    struct source_stamp {
+        std::string path;
+        uint64_t size = 0;
+        int64_t modification_time = 0;
+    };
+
+    struct frame {
+        std::vector<file_loader::vertex> vertices;
+        file_loader::digital_camera_params camera_params;
+        std::vector<file_loader::image> images;
+    };
+
+    // one cache per frame next to the recording folder, frames of an archive share their source files so the stamps alone
+    // cannot tell them apart
+    static std::string get_cache_path(const std::string& folder_name, int frame_number);
+    static bool get_source_stamp(const std::string& path, source_stamp& stamp);
+    static uint64_t hash_sources(const std::vector<std::string>& sources);
+
+    // fails if the cache is missing, has another version or any of the sources changed since it was written
+    static bool load(const std::string& cache_path, const std::vector<std::string>& sources, frame& frame);
+    // a failed save leaves neither the cache nor its temporary file behind
+    static bool save(const std::string& cache_path, const std::vector<std::string>& sources, const frame& frame);
+
+private:
+    // a stored modification time that no longer matches although the content hash does
+    struct outdated_stamp {
+        size_t offset = 0;
+        int64_t modification_time = 0;
+    };
+
+    static bool read(const std::string& cache_path, const std::vector<std::string>& sources, frame& frame,
+                     std::vector<outdated_stamp>& outdated_stamps);
+    // writes the current modification times over the outdated ones, once the cache is no longer mapped
+    static void refresh_stamps(const std::string& cache_path, const std::vector<outdated_stamp>& outdated_stamps);
+};
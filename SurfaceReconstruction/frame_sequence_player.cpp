@@ -0,0 +1,276 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <filesystem>
+#include "frame_sequence_player.h"
+
+static double get_time_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+frame_sequence_player::~frame_sequence_player() {
+    stop();
+}
+
+std::vector<frame_sequence_player::frame_files> frame_sequence_player::find_frames(const std::string& folder_name) {
+    const std::string manifest_path = dataset_manifest::get_manifest_path(folder_name);
+    std::error_code error;
+    dataset_manifest manifest;
+    if (std::filesystem::exists(manifest_path, error) && manifest.load(manifest_path)) {
+        return manifest.get_frames();
+    }
+    return dataset_manifest::scan_folder(folder_name);
+}
+
+bool frame_sequence_player::is_pcap_file(const std::string& path) {
+    const std::string extension = std::filesystem::path(path).extension().string();
+    return extension == ".pcap" || extension == ".PCAP";
+}
+
+bool frame_sequence_player::start(const std::string& path, const float frames_per_second, const size_t prefetch_count, const bool is_looping) {
+    stop();
+
+    m_frames.clear();
+    m_pcap_reader.reset();
+    m_archive_reader.reset();
+    if (frame_archive::is_archive_file(path)) {
+        m_archive_reader = std::make_unique<frame_archive_reader>();
+        if (!m_archive_reader->open(path) || m_archive_reader->get_frame_count() == 0) {
+            m_archive_reader.reset();
+            return false;
+        }
+        std::cout << "Playing " << m_archive_reader->get_frame_count() << " frames from archive " << path << std::endl;
+    } else if (is_pcap_file(path)) {
+        m_pcap_reader = std::make_unique<velodyne_pcap_reader>();
+        if (!m_pcap_reader->open(path)) {
+            m_pcap_reader.reset();
+            return false;
+        }
+        std::cout << "Playing VLP-16 recording " << path << std::endl;
+    } else {
+        m_frames = find_frames(path);
+        if (m_frames.empty()) {
+            std::cerr << "No fnNNN frames found in " << path << std::endl;
+            return false;
+        }
+        std::cout << "Playing " << m_frames.size() << " frames from " << path << " (fn" << m_frames.front().frame_number
+            << " - fn" << m_frames.back().frame_number << ")" << std::endl;
+    }
+
+    m_prefetch_count = prefetch_count > 0 ? prefetch_count : 1;
+    m_is_looping = is_looping;
+    m_is_clock_started = false;
+    m_late_frame_count = 0;
+    set_frames_per_second(frames_per_second);
+    m_is_stop_requested = false;
+    m_is_decoder_finished = false;
+    m_decoder_thread = std::thread(&frame_sequence_player::decode_loop, this);
+    return true;
+}
+
+void frame_sequence_player::stop() {
+    if (!m_decoder_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_is_stop_requested = true;
+    }
+    m_buffer_not_full.notify_all();
+    m_decoder_thread.join();
+    m_buffer.clear();
+}
+
+void frame_sequence_player::set_frames_per_second(const float frames_per_second) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frame_period = 1.0 / std::max(frames_per_second, 0.1f);
+}
+
+bool frame_sequence_player::poll(frame& frame) {
+    const double now = get_time_seconds();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_is_clock_started) {
+        if (m_buffer.empty()) {
+            return false;
+        }
+        m_next_frame_time = now;
+        m_is_clock_started = true;
+    }
+    if (now < m_next_frame_time) {
+        return false;
+    }
+
+    if (m_buffer.empty()) {
+        if (m_is_decoder_finished) {
+            return false;
+        }
+        // the presentation time passed without a decoded frame, the current one stays on screen for another period
+        ++m_late_frame_count;
+        m_next_frame_time += m_frame_period;
+        return false;
+    }
+
+    frame = std::move(m_buffer.front());
+    m_buffer.pop_front();
+    m_next_frame_time += m_frame_period;
+    if (m_next_frame_time < now) {
+        m_next_frame_time = now;
+    }
+    lock.unlock();
+    m_buffer_not_full.notify_one();
+    return true;
+}
+
+bool frame_sequence_player::is_playing() const {
+    if (!m_decoder_thread.joinable()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_is_decoder_finished || !m_buffer.empty();
+}
+
+size_t frame_sequence_player::get_late_frame_count() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_late_frame_count;
+}
+
+size_t frame_sequence_player::get_buffered_frame_count() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_buffer.size();
+}
+
+void frame_sequence_player::decode_loop() {
+    if (m_pcap_reader) {
+        decode_pcap_loop();
+    } else if (m_archive_reader) {
+        decode_archive_loop();
+    } else {
+        decode_folder_loop();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_is_decoder_finished = true;
+}
+
+void frame_sequence_player::decode_folder_loop() {
+    size_t index = 0;
+    size_t failed_in_a_row = 0;
+    while (!m_is_stop_requested && failed_in_a_row < m_frames.size()) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_buffer_not_full.wait(lock, [this] { return m_is_stop_requested || m_buffer.size() < m_prefetch_count; });
+            if (m_is_stop_requested) {
+                return;
+            }
+        }
+
+        if (index == m_frames.size()) {
+            if (!m_is_looping) {
+                return;
+            }
+            index = 0;
+        }
+
+        // decoding happens outside of the lock so the render thread can keep polling
+        frame decoded;
+        decoded.index = index;
+        if (!decode_frame(m_frames[index], decoded)) {
+            std::cerr << "Skipping frame fn" << m_frames[index].frame_number << std::endl;
+            ++failed_in_a_row;
+            ++index;
+            continue;
+        }
+        failed_in_a_row = 0;
+        ++index;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffer.push_back(std::move(decoded));
+    }
+}
+
+void frame_sequence_player::decode_pcap_loop() {
+    velodyne_pcap_reader::frame revolution;
+    while (!m_is_stop_requested) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_buffer_not_full.wait(lock, [this] { return m_is_stop_requested || m_buffer.size() < m_prefetch_count; });
+            if (m_is_stop_requested) {
+                return;
+            }
+        }
+
+        if (!m_pcap_reader->read_frame(revolution)) {
+            std::cout << "Replayed " << m_pcap_reader->get_packet_count() << " data packets" << std::endl;
+            if (!m_is_looping || m_pcap_reader->get_packet_count() == 0) {
+                return;
+            }
+            m_pcap_reader->rewind();
+            continue;
+        }
+
+        frame decoded;
+        decoded.frame_number = (int)revolution.index;
+        decoded.index = revolution.index;
+        decoded.points = point_cloud::from_vertices(revolution.vertices, false);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffer.push_back(std::move(decoded));
+    }
+}
+
+void frame_sequence_player::decode_archive_loop() {
+    size_t index = 0;
+    size_t failed_in_a_row = 0;
+    const size_t frame_count = m_archive_reader->get_frame_count();
+    std::vector<file_loader::vertex> vertices;
+    while (!m_is_stop_requested && failed_in_a_row < frame_count) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_buffer_not_full.wait(lock, [this] { return m_is_stop_requested || m_buffer.size() < m_prefetch_count; });
+            if (m_is_stop_requested) {
+                return;
+            }
+        }
+
+        if (index == frame_count) {
+            if (!m_is_looping) {
+                return;
+            }
+            index = 0;
+        }
+
+        frame decoded;
+        decoded.index = index;
+        decoded.frame_number = m_archive_reader->get_entry(index).frame_number;
+        if (!m_archive_reader->read_frame(index, vertices)) {
+            std::cerr << "Skipping corrupt archive frame " << index << std::endl;
+            ++failed_in_a_row;
+            ++index;
+            continue;
+        }
+        decoded.points = point_cloud::from_vertices(vertices, false);
+        failed_in_a_row = 0;
+        ++index;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffer.push_back(std::move(decoded));
+    }
+}
+
+bool frame_sequence_player::decode_frame(const frame_files& files, frame& frame) {
+    frame.frame_number = files.frame_number;
+    frame.images.resize(3);
+    std::future<bool> image_decodes[3];
+    for (int i = 0; i < 3; ++i) {
+        if (!files.images[i].empty()) {
+            image_decodes[i] = std::async(std::launch::async, dataset_manifest::load_image, std::cref(files.images[i]), std::ref(frame.images[i]));
+        }
+    }
+    frame.points = dataset_manifest::load_point_cloud(files.points);
+    for (auto& image_decode : image_decodes) {
+        if (image_decode.valid()) {
+            image_decode.wait();
+        }
+    }
+    return !frame.points.empty();
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "file_loader.h"
+#include "velodyne_pcap_reader.h"
+#include "frame_archive.h"
+#include "dataset_manifest.h"
+#include "point_cloud.h"
+
+// plays the consecutive fnNNN frames of a recording folder (or the revolutions of a VLP-16 .pcap recording, or the
+// frames of a .srarc archive) in order,
+// a background thread keeps the next few frames decoded so that polling from the render loop never waits for the disk
+class frame_sequence_player {
+public:
+    using frame_files = dataset_manifest::frame_entry;
+
+    struct frame {
+        int frame_number = -1;
+        size_t index = 0;
+        // positions and intensities, converted on the decoder thread so the render thread only moves them
+        point_cloud points;
+        std::vector<file_loader::image> images;
+    };
+
+    frame_sequence_player() = default;
+    ~frame_sequence_player();
+
+    frame_sequence_player(const frame_sequence_player&) = delete;
+    frame_sequence_player& operator=(const frame_sequence_player&) = delete;
+
+    // the frame table of the folder's dataset.json, or a directory scan when it has none
+    static std::vector<frame_files> find_frames(const std::string& folder_name);
+
+    static bool is_pcap_file(const std::string& path);
+
+    // path is either a folder of fnNNN frames, a .pcap or a .srarc file
+    bool start(const std::string& path, float frames_per_second, size_t prefetch_count = 3, bool is_looping = true);
+    void stop();
+
+    // returns true and moves out the next frame once its presentation time has come, never blocks on decoding
+    bool poll(frame& frame);
+
+    // false once the decoder ran out of frames (a non looping source ended or every frame failed) and the buffer is drained
+    bool is_playing() const;
+    size_t get_frame_count() const { return m_archive_reader ? m_archive_reader->get_frame_count() : m_frames.size(); }
+    // presentation times that passed while the decoder had no frame ready, the previous frame stayed on screen instead
+    size_t get_late_frame_count() const;
+    size_t get_buffered_frame_count() const;
+    void set_frames_per_second(float frames_per_second);
+
+private:
+    void decode_loop();
+    void decode_folder_loop();
+    void decode_pcap_loop();
+    void decode_archive_loop();
+    static bool decode_frame(const frame_files& files, frame& frame);
+
+    std::vector<frame_files> m_frames;
+    std::unique_ptr<velodyne_pcap_reader> m_pcap_reader;
+    std::unique_ptr<frame_archive_reader> m_archive_reader;
+    std::deque<frame> m_buffer;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_buffer_not_full;
+    std::thread m_decoder_thread;
+    std::atomic<bool> m_is_stop_requested{false};
+    std::atomic<bool> m_is_decoder_finished{false};
+
+    size_t m_prefetch_count = 3;
+    bool m_is_looping = true;
+    double m_frame_period = 0.1;
+    double m_next_frame_time = 0.0;
+    bool m_is_clock_started = false;
+    size_t m_late_frame_count = 0;
+};
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <cstring>
+#include "image_decoder.h"
+
+#ifdef SURFACE_RECONSTRUCTION_NO_SDL_IMAGE
+// headless builds without SDL_image: camera images are not decoded, the points keep their intensity colors
+bool image_decoder::is_available() {
+    return false;
+}
+
+bool image_decoder::decode_file(const std::string& filename, file_loader::image&) {
+    std::cerr << "Built without image decoding, skipping " << filename << std::endl;
+    return false;
+}
+
+bool image_decoder::decode_memory(const void*, size_t, file_loader::image&, const std::string& name) {
+    std::cerr << "Built without image decoding, skipping " << name << std::endl;
+    return false;
+}
+#else
+#include <SDL.h>
+#include <SDL_image.h>
+
+bool image_decoder::is_available() {
+    return true;
+}
+
+bool image_decoder::decode_file(const std::string& filename, file_loader::image& image) {
+    SDL_Surface* loaded_img = IMG_Load(filename.c_str());
+    if (loaded_img == nullptr) {
+        std::cerr << "Error loading image file " << filename << ": " << IMG_GetError() << std::endl;
+        return false;
+    }
+    return read_surface(loaded_img, filename, image);
+}
+
+bool image_decoder::decode_memory(const void* data, const size_t size, file_loader::image& image, const std::string& name) {
+    SDL_RWops* stream = SDL_RWFromConstMem(data, (int)size);
+    SDL_Surface* loaded_img = stream != nullptr ? IMG_Load_RW(stream, 1) : nullptr;
+    if (loaded_img == nullptr) {
+        std::cerr << "Error decoding image " << name << ": " << IMG_GetError() << std::endl;
+        return false;
+    }
+    return read_surface(loaded_img, name, image);
+}
+
+// takes ownership of the surface
+bool image_decoder::read_surface(SDL_Surface* loaded_img, const std::string& filename, file_loader::image& image) {
+    const Uint32 sdl_format = loaded_img->format->BytesPerPixel == 3 ? SDL_PIXELFORMAT_RGB24 : SDL_PIXELFORMAT_RGBA32;
+    if (loaded_img->format->format != sdl_format) {
+        SDL_Surface* formatted_img = SDL_ConvertSurfaceFormat(loaded_img, sdl_format, 0);
+        SDL_FreeSurface(loaded_img);
+        if (formatted_img == nullptr) {
+            std::cerr << "Error converting image format of " << filename << ": " << SDL_GetError() << std::endl;
+            return false;
+        }
+        loaded_img = formatted_img;
+    }
+
+    image.width = loaded_img->w;
+    image.height = loaded_img->h;
+    image.channels = sdl_format == SDL_PIXELFORMAT_RGB24 ? 3 : 4;
+    const size_t row_size = (size_t)image.width * image.channels;
+    image.pixels.resize(row_size * image.height);
+
+    // SDL has (0,0) in the top left corner, OpenGL textures in the bottom left
+    const auto* src = static_cast<const uint8_t*>(loaded_img->pixels);
+    for (int y = 0; y < image.height; ++y) {
+        std::memcpy(image.pixels.data() + (size_t)(image.height - 1 - y) * row_size, src + (size_t)y * loaded_img->pitch, row_size);
+    }
+
+    SDL_FreeSurface(loaded_img);
+    return true;
+}
+#endif
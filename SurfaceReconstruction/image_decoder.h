@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include "file_loader.h"
+
+struct SDL_Surface;
+
+class image_decoder {
+public:
+    // false in headless builds made without SDL_image
+    static bool is_available();
+    // decodes to tightly packed RGB or RGBA rows, bottom row first as OpenGL textures expect it
+    static bool decode_file(const std::string& filename, file_loader::image& image);
+    // decodes an encoded image (jpeg, png, ...) that is already in memory, e.g. a byte range of a packed dataset
+    static bool decode_memory(const void* data, size_t size, file_loader::image& image, const std::string& name = "memory");
+
+private:
+    static bool read_surface(SDL_Surface* surface, const std::string& name, file_loader::image& image);
+};
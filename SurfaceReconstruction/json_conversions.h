@@ -0,0 +1,68 @@
+#pragma once
+#include <charconv>
+#include <cstdlib>
+#include <glm/glm.hpp>
+#include "Includes/json.hpp"
+#include "file_loader.h"
+
+// nlohmann::json conversions of the camera parameter types, found through ADL by json::get and json assignment.
+// R is read row by row into r[row][column], the same order the text parameter files use.
+
+// the shortest decimal form of a float, so 0.923f is written as 0.923 and not as its widened double value
+inline double get_json_number(const float value) {
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer) - 1, value);
+    *result.ptr = '\0';
+    return std::strtod(buffer, nullptr);
+}
+
+namespace glm {
+    inline void to_json(nlohmann::json& json, const vec3& v) {
+        json = nlohmann::json::array({get_json_number(v.x), get_json_number(v.y), get_json_number(v.z)});
+    }
+
+    inline void from_json(const nlohmann::json& json, vec3& v) {
+        v = vec3(json.at(0).get<float>(), json.at(1).get<float>(), json.at(2).get<float>());
+    }
+}
+
+inline void to_json(nlohmann::json& json, const file_loader::device& device) {
+    nlohmann::json r = nlohmann::json::array();
+    for (int i = 0; i < 3; ++i) {
+        r.push_back({get_json_number(device.r[i][0]), get_json_number(device.r[i][1]), get_json_number(device.r[i][2])});
+    }
+    json = {{"name", device.name}, {"R", r}, {"t", device.t}};
+}
+
+inline void from_json(const nlohmann::json& json, file_loader::device& device) {
+    json.at("name").get_to(device.name);
+    const auto& r = json.at("R");
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            device.r[i][j] = r.at(i).at(j).get<float>();
+        }
+    }
+    json.at("t").get_to(device.t);
+}
+
+inline void to_json(nlohmann::json& json, const file_loader::digital_camera_params& camera_params) {
+    const auto& internal_params = camera_params.internal_params;
+    json = {
+        {"internal_params", {
+            {"fu", get_json_number(internal_params.fu)},
+            {"u0", get_json_number(internal_params.u0)},
+            {"fv", get_json_number(internal_params.fv)},
+            {"v0", get_json_number(internal_params.v0)}
+        }},
+        {"devices", camera_params.devices}
+    };
+}
+
+inline void from_json(const nlohmann::json& json, file_loader::digital_camera_params& camera_params) {
+    const auto& internal_params = json.at("internal_params");
+    internal_params.at("fu").get_to(camera_params.internal_params.fu);
+    internal_params.at("u0").get_to(camera_params.internal_params.u0);
+    internal_params.at("fv").get_to(camera_params.internal_params.fv);
+    internal_params.at("v0").get_to(camera_params.internal_params.v0);
+    json.at("devices").get_to(camera_params.devices);
+}
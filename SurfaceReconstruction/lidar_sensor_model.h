@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+
+// Describes how the points of an exported lidar frame are laid out. After dropping the duplicated returns the
+// points come in blocks of columns_per_block firing columns, stored beam pair by beam pair. The loaders reorder
+// every block so that each column holds beam_count consecutive points in ring order, which is what the mesher
+// walks with its i + 1 / i + beam_count strides. firing_order maps the stored beam index to its ring.
+template <int BeamCount, int ColumnsPerBlock>
+struct lidar_sensor_model {
+    static_assert(BeamCount % 2 == 0, "beams are stored in pairs, the beam count has to be even");
+
+    static constexpr int beam_count = BeamCount;
+    static constexpr int columns_per_block = ColumnsPerBlock;
+    static constexpr int block_size = BeamCount * ColumnsPerBlock;
+
+    static constexpr std::array<int, BeamCount> identity_firing_order() {
+        std::array<int, BeamCount> order{};
+        for (int beam = 0; beam < BeamCount; ++beam) {
+            order[beam] = beam;
+        }
+        return order;
+    }
+};
+
+struct vlp16_sensor : lidar_sensor_model<16, 12> {
+    static constexpr const char* name = "vlp16";
+    static constexpr std::array<int, beam_count> firing_order = identity_firing_order();
+};
+
+struct vlp32_sensor : lidar_sensor_model<32, 12> {
+    static constexpr const char* name = "vlp32";
+    static constexpr std::array<int, beam_count> firing_order = identity_firing_order();
+};
+
+struct hdl64_sensor : lidar_sensor_model<64, 12> {
+    static constexpr const char* name = "hdl64";
+    static constexpr std::array<int, beam_count> firing_order = identity_firing_order();
+};
+
+// reorder_indices[i] is the kept record of a block that ends up at index i of the block
+template <typename Sensor>
+constexpr std::array<int, Sensor::block_size> make_reorder_indices() {
+    std::array<int, Sensor::block_size> indices{};
+    constexpr int half_beam_count = Sensor::beam_count / 2;
+    for (int record = 0; record < Sensor::block_size; ++record) {
+        const int beam_pair = record / (2 * Sensor::columns_per_block);
+        const int position_in_pair = record % (2 * Sensor::columns_per_block);
+        const int column = Sensor::columns_per_block - 1 - position_in_pair % Sensor::columns_per_block;
+        const int beam = beam_pair + half_beam_count * (position_in_pair / Sensor::columns_per_block);
+        indices[column * Sensor::beam_count + Sensor::firing_order[beam]] = record;
+    }
+    return indices;
+}
+
+// inverse of reorder_indices: the index inside its block where the n-th kept record is stored
+template <typename Sensor>
+constexpr std::array<int, Sensor::block_size> make_ring_order_slots() {
+    const std::array<int, Sensor::block_size> indices = make_reorder_indices<Sensor>();
+    std::array<int, Sensor::block_size> slots{};
+    for (int i = 0; i < Sensor::block_size; ++i) {
+        slots[indices[i]] = i;
+    }
+    return slots;
+}
+
+// permutation tables derived from a sensor model at compile time
+template <typename Sensor>
+struct lidar_frame_layout {
+    static constexpr int beam_count = Sensor::beam_count;
+    static constexpr int columns_per_block = Sensor::columns_per_block;
+    static constexpr int block_size = Sensor::block_size;
+    static constexpr std::array<int, block_size> reorder_indices = make_reorder_indices<Sensor>();
+    static constexpr std::array<int, block_size> ring_order_slots = make_ring_order_slots<Sensor>();
+};
+
+// the sensor the application is built for, e.g. /DLIDAR_SENSOR_MODEL=vlp32_sensor
+#ifndef LIDAR_SENSOR_MODEL
+#define LIDAR_SENSOR_MODEL vlp16_sensor
+#endif
+using active_sensor_model = LIDAR_SENSOR_MODEL;
@@ -0,0 +1,497 @@
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "linear_octree.h"
+
+namespace {
+    // below this many points the threads cost more than they save
+    constexpr size_t parallel_point_count = 1 << 16;
+    constexpr size_t parallel_query_count = 1 << 12;
+    constexpr int radix_bits = 8;
+    constexpr int radix_size = 1 << radix_bits;
+
+    size_t get_thread_count(const size_t thread_count, const size_t count, const size_t parallel_count) {
+        if (count < parallel_count) {
+            return 1;
+        }
+        return thread_count == 0 ? std::max(1u, std::thread::hardware_concurrency()) : thread_count;
+    }
+
+    template <typename Function>
+    void parallel_for(const size_t thread_count, const size_t count, const Function& function) {
+        if (thread_count <= 1) {
+            function(0, count, 0);
+            return;
+        }
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < thread_count; ++t) {
+            threads.emplace_back(function, count * t / thread_count, count * (t + 1) / thread_count, t);
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // spreads the lower 21 bits of value so there are two zero bits between each of them
+    uint64_t spread_bits(uint64_t value) {
+        value &= 0x1fffff;
+        value = (value | value << 32) & 0x1f00000000ffff;
+        value = (value | value << 16) & 0x1f0000ff0000ff;
+        value = (value | value << 8) & 0x100f00f00f00f00f;
+        value = (value | value << 4) & 0x10c30c30c30c30c3;
+        value = (value | value << 2) & 0x1249249249249249;
+        return value;
+    }
+
+    // stable LSD radix sort of the codes and their point indices, each pass is split across the threads: every thread
+    // counts the digits of its slice into its radix_size entries of histograms, the prefix sums give every (digit, thread)
+    // pair its place in the output. The buffers are the caller's so a rebuild reuses them.
+    void radix_sort(std::vector<uint64_t>& codes, std::vector<uint32_t>& indices, std::vector<uint64_t>& code_buffer,
+                    std::vector<uint32_t>& index_buffer, std::vector<size_t>& histograms, const size_t thread_count) {
+        const size_t count = codes.size();
+        code_buffer.resize(count);
+        index_buffer.resize(count);
+        histograms.resize(thread_count * radix_size);
+        for (int shift = 0; shift < 3 * linear_octree::max_level; shift += radix_bits) {
+            parallel_for(thread_count, count, [&](const size_t begin, const size_t end, const size_t t) {
+                size_t* histogram = histograms.data() + t * radix_size;
+                std::fill(histogram, histogram + radix_size, 0);
+                for (size_t i = begin; i < end; ++i) {
+                    ++histogram[(codes[i] >> shift) & (radix_size - 1)];
+                }
+            });
+
+            // the high digits are often the same for all points of a frame, those passes would only copy
+            bool is_single_digit = false;
+            size_t offset = 0;
+            for (int digit = 0; digit < radix_size; ++digit) {
+                size_t digit_count = 0;
+                for (size_t t = 0; t < thread_count; ++t) {
+                    size_t& thread_digit = histograms[t * radix_size + digit];
+                    const size_t thread_digit_count = thread_digit;
+                    thread_digit = offset;
+                    offset += thread_digit_count;
+                    digit_count += thread_digit_count;
+                }
+                is_single_digit |= digit_count == count;
+            }
+            if (is_single_digit) {
+                continue;
+            }
+
+            parallel_for(thread_count, count, [&](const size_t begin, const size_t end, const size_t t) {
+                size_t* offsets = histograms.data() + t * radix_size;
+                for (size_t i = begin; i < end; ++i) {
+                    const size_t destination = offsets[(codes[i] >> shift) & (radix_size - 1)]++;
+                    code_buffer[destination] = codes[i];
+                    index_buffer[destination] = indices[i];
+                }
+            });
+            codes.swap(code_buffer);
+            indices.swap(index_buffer);
+        }
+    }
+
+    float get_box_squared_distance(const glm::vec3& point, const glm::vec3& min, const glm::vec3& size) {
+        const glm::vec3 outside = glm::max(glm::max(min - point, point - (min + size)), glm::vec3(0.0f));
+        return glm::dot(outside, outside);
+    }
+
+    // the last 3 bits of a node's code are its octant in the parent, z y x
+    glm::vec3 get_child_min(const glm::vec3& parent_min, const uint64_t child_code, const glm::vec3& child_size) {
+        return parent_min + glm::vec3((float)(child_code & 1), (float)(child_code >> 1 & 1), (float)(child_code >> 2 & 1)) * child_size;
+    }
+}
+
+struct linear_octree::search_buffer {
+    struct entry {
+        float squared_distance;
+        uint32_t node;
+        glm::vec3 min;
+    };
+
+    // the queue of knn, the stack of radius
+    std::vector<entry> entries;
+    std::vector<float> distances;
+};
+
+int linear_octree::node::get_child_count() const {
+    int count = 0;
+    for (uint8_t mask = child_mask; mask != 0; mask &= mask - 1) {
+        ++count;
+    }
+    return count;
+}
+
+uint64_t linear_octree::get_morton_code(const uint32_t x, const uint32_t y, const uint32_t z) {
+    return spread_bits(x) | spread_bits(y) << 1 | spread_bits(z) << 2;
+}
+
+void linear_octree::build(const point_cloud& points, const size_t leaf_capacity, const int max_depth, size_t thread_count,
+                          build_statistics* statistics, std::vector<uint32_t>* rejected_indices) {
+    using steady_clock = std::chrono::steady_clock;
+    const auto code_start = steady_clock::now();
+    clear();
+    thread_count = get_thread_count(thread_count, points.size(), parallel_point_count);
+
+    const float* x = points.get_x();
+    const float* y = points.get_y();
+    const float* z = points.get_z();
+    // the scratch vectors keep their capacity from the previous build, so rebuilding every frame does not allocate
+    std::vector<uint32_t>& valid_indices = m_point_indices;
+    valid_indices.reserve(points.size());
+    glm::vec3 min_position(std::numeric_limits<float>::max());
+    glm::vec3 max_position(std::numeric_limits<float>::lowest());
+    const size_t first_rejected = rejected_indices ? rejected_indices->size() : 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (x[i] != 0.0f || y[i] != 0.0f || z[i] != 0.0f) {
+            valid_indices.push_back((uint32_t)i);
+            min_position = glm::min(min_position, glm::vec3(x[i], y[i], z[i]));
+            max_position = glm::max(max_position, glm::vec3(x[i], y[i], z[i]));
+        } else if (rejected_indices) {
+            rejected_indices->push_back((uint32_t)i);
+        }
+    }
+    const size_t skipped_count = points.size() - valid_indices.size();
+    if (valid_indices.empty()) {
+        if (statistics) {
+            *statistics = build_statistics{};
+            statistics->skipped_points = skipped_count;
+        }
+        return;
+    }
+    m_boundary = octree::boundary{min_position, max_position};
+    m_max_depth = std::clamp(max_depth, 0, max_level);
+    for (int level = 0; level <= m_max_depth; ++level) {
+        m_cell_sizes[level] = (max_position - min_position) / (float)(1u << level);
+    }
+
+    // the bounds are split into 2^21 cells per axis, the points on the upper bound go to the last cell
+    constexpr uint32_t max_cell = (1u << max_level) - 1;
+    const glm::vec3 extent = max_position - min_position;
+    const glm::vec3 scale(extent.x > 0.0f ? (max_cell + 1) / extent.x : 0.0f,
+                          extent.y > 0.0f ? (max_cell + 1) / extent.y : 0.0f,
+                          extent.z > 0.0f ? (max_cell + 1) / extent.z : 0.0f);
+    std::vector<uint64_t>& codes = m_codes;
+    codes.resize(valid_indices.size());
+    parallel_for(thread_count, codes.size(), [&](const size_t begin, const size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t index = valid_indices[i];
+            const uint32_t cell_x = std::min((uint32_t)((x[index] - min_position.x) * scale.x), max_cell);
+            const uint32_t cell_y = std::min((uint32_t)((y[index] - min_position.y) * scale.y), max_cell);
+            const uint32_t cell_z = std::min((uint32_t)((z[index] - min_position.z) * scale.z), max_cell);
+            codes[i] = get_morton_code(cell_x, cell_y, cell_z);
+        }
+    });
+
+    const auto sort_start = steady_clock::now();
+    radix_sort(codes, valid_indices, m_code_buffer, m_index_buffer, m_histograms, thread_count);
+
+    // the same position gives the same code, so the repeats of a point are in its run of equal codes. The sort is stable,
+    // the runs are in increasing index order and the first of the repeats is kept. The kept points are moved to the front.
+    size_t kept_count = 0;
+    for (size_t run_begin = 0; run_begin < codes.size();) {
+        size_t run_end = run_begin + 1;
+        while (run_end < codes.size() && codes[run_end] == codes[run_begin]) {
+            ++run_end;
+        }
+        const size_t run_kept_begin = kept_count;
+        for (size_t i = run_begin; i < run_end; ++i) {
+            const uint32_t index = valid_indices[i];
+            bool is_duplicate = false;
+            for (size_t kept = run_kept_begin; kept < kept_count && !is_duplicate; ++kept) {
+                const uint32_t kept_index = valid_indices[kept];
+                is_duplicate = x[index] == x[kept_index] && y[index] == y[kept_index] && z[index] == z[kept_index];
+            }
+            if (is_duplicate) {
+                if (rejected_indices) {
+                    rejected_indices->push_back(index);
+                }
+                continue;
+            }
+            codes[kept_count] = codes[i];
+            valid_indices[kept_count] = index;
+            ++kept_count;
+        }
+        run_begin = run_end;
+    }
+    const size_t duplicate_count = codes.size() - kept_count;
+    codes.resize(kept_count);
+    valid_indices.resize(kept_count);
+    if (rejected_indices) {
+        std::sort(rejected_indices->begin() + first_rejected, rejected_indices->end());
+    }
+
+    m_x.resize(m_point_indices.size());
+    m_y.resize(m_point_indices.size());
+    m_z.resize(m_point_indices.size());
+    parallel_for(thread_count, m_point_indices.size(), [&](const size_t begin, const size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+            m_x[i] = x[m_point_indices[i]];
+            m_y[i] = y[m_point_indices[i]];
+            m_z[i] = z[m_point_indices[i]];
+        }
+    });
+
+    // breadth first: the nodes vector is its own queue, children are appended as one contiguous group
+    const auto node_start = steady_clock::now();
+    m_nodes.reserve(codes.size() / std::max<size_t>(leaf_capacity, 1) * 2 + 1);
+    m_nodes.push_back(node{0, 0, 0, (uint32_t)codes.size(), 0, 0});
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        const node current = m_nodes[i];
+        if (current.get_point_count() <= leaf_capacity || current.level == m_max_depth ||
+            codes[current.point_begin] == codes[current.point_end - 1]) {
+            continue;
+        }
+        const int child_shift = 3 * (max_level - 1 - current.level);
+        auto begin = codes.begin() + current.point_begin;
+        const auto end = codes.begin() + current.point_end;
+        const uint32_t first_child = (uint32_t)m_nodes.size();
+        uint8_t child_mask = 0;
+        for (uint64_t octant = 0; octant < 8 && begin != end; ++octant) {
+            const auto octant_end = std::partition_point(begin, end, [&](const uint64_t code) { return ((code >> child_shift) & 7) <= octant; });
+            if (octant_end != begin) {
+                child_mask |= (uint8_t)(1 << octant);
+                m_nodes.push_back(node{current.code << 3 | octant, 0, (uint32_t)(begin - codes.begin()), (uint32_t)(octant_end - codes.begin()),
+                                       0, (uint8_t)(current.level + 1)});
+            }
+            begin = octant_end;
+        }
+        m_nodes[i].first_child = first_child;
+        m_nodes[i].child_mask = child_mask;
+    }
+    const auto node_end = steady_clock::now();
+
+    if (statistics) {
+        statistics->points = m_point_indices.size();
+        statistics->duplicate_points = duplicate_count;
+        statistics->skipped_points = skipped_count;
+        statistics->nodes = m_nodes.size();
+        statistics->code_seconds = std::chrono::duration<double>(sort_start - code_start).count();
+        statistics->sort_seconds = std::chrono::duration<double>(node_start - sort_start).count();
+        statistics->node_seconds = std::chrono::duration<double>(node_end - node_start).count();
+    }
+}
+
+void linear_octree::clear() {
+    m_boundary = octree::boundary{};
+    m_max_depth = 0;
+    std::fill(m_cell_sizes, m_cell_sizes + max_level + 1, glm::vec3(0.0f));
+    m_nodes.clear();
+    m_point_indices.clear();
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_codes.clear();
+}
+
+octree::boundary linear_octree::get_node_boundary(const node& node) const {
+    // the bits of the code are z y x per level, starting with the root's children
+    uint32_t cell[3] = {0, 0, 0};
+    for (int level = 0; level < node.level; ++level) {
+        const uint64_t octant = node.code >> 3 * (node.level - 1 - level);
+        for (int axis = 0; axis < 3; ++axis) {
+            cell[axis] = cell[axis] << 1 | (uint32_t)(octant >> axis & 1);
+        }
+    }
+    const glm::vec3 top_left_front = m_boundary.m_top_left_front + glm::vec3(cell[0], cell[1], cell[2]) * m_cell_sizes[node.level];
+    return octree::boundary{top_left_front, top_left_front + m_cell_sizes[node.level]};
+}
+
+size_t linear_octree::get_memory_size() const {
+    return m_nodes.capacity() * sizeof(node) + (m_point_indices.capacity() + m_index_buffer.capacity()) * sizeof(uint32_t) +
+        (m_x.capacity() + m_y.capacity() + m_z.capacity()) * sizeof(float) + (m_codes.capacity() + m_code_buffer.capacity()) * sizeof(uint64_t);
+}
+
+void linear_octree::knn(const glm::vec3& point, const size_t k, std::vector<neighbor>& neighbors) const {
+    search_buffer buffer;
+    knn(point, k, neighbors, buffer);
+}
+
+void linear_octree::radius(const glm::vec3& point, const float search_radius, std::vector<neighbor>& neighbors) const {
+    search_buffer buffer;
+    radius(point, search_radius, neighbors, buffer);
+}
+
+void linear_octree::knn(const point_cloud& queries, const size_t k, neighbor_lists& lists, const size_t thread_count) const {
+    query(queries, lists, thread_count, [this, k](const glm::vec3& point, std::vector<neighbor>& neighbors, search_buffer& buffer) {
+        knn(point, k, neighbors, buffer);
+    });
+}
+
+void linear_octree::radius(const point_cloud& queries, const float search_radius, neighbor_lists& lists, const size_t thread_count) const {
+    query(queries, lists, thread_count, [this, search_radius](const glm::vec3& point, std::vector<neighbor>& neighbors, search_buffer& buffer) {
+        radius(point, search_radius, neighbors, buffer);
+    });
+}
+
+void linear_octree::knn(const glm::vec3& point, const size_t k, std::vector<neighbor>& neighbors, search_buffer& buffer) const {
+    neighbors.clear();
+    if (empty() || k == 0) {
+        return;
+    }
+    // the queue is a min heap of box distances, the neighbors a max heap of point distances while the search runs
+    auto is_farther_entry = [](const search_buffer::entry& a, const search_buffer::entry& b) { return a.squared_distance > b.squared_distance; };
+    auto is_closer_neighbor = [](const neighbor& a, const neighbor& b) { return a.squared_distance < b.squared_distance; };
+    auto scan_points = [&](const uint32_t begin, const uint32_t end) {
+        buffer.distances.resize(end - begin);
+        const float* x = m_x.data() + begin;
+        const float* y = m_y.data() + begin;
+        const float* z = m_z.data() + begin;
+        for (uint32_t i = 0; i < end - begin; ++i) {
+            const float dx = x[i] - point.x;
+            const float dy = y[i] - point.y;
+            const float dz = z[i] - point.z;
+            buffer.distances[i] = dx * dx + dy * dy + dz * dz;
+        }
+        for (uint32_t i = 0; i < end - begin; ++i) {
+            if (neighbors.size() < k) {
+                neighbors.push_back({m_point_indices[begin + i], buffer.distances[i]});
+                std::push_heap(neighbors.begin(), neighbors.end(), is_closer_neighbor);
+            } else if (buffer.distances[i] < neighbors.front().squared_distance) {
+                std::pop_heap(neighbors.begin(), neighbors.end(), is_closer_neighbor);
+                neighbors.back() = {m_point_indices[begin + i], buffer.distances[i]};
+                std::push_heap(neighbors.begin(), neighbors.end(), is_closer_neighbor);
+            }
+        }
+    };
+
+    // the smallest node around the point that still has k points is scanned first: its points bound the distance
+    // before anything is queued, so most nodes on the way down are never pushed. Its subtree is skipped afterwards.
+    // A node with k points can still be large next to a sparse octant, then the descent goes on to a smaller one.
+    const size_t max_home_points = 8 * k;
+    uint32_t home = 0;
+    glm::vec3 home_min = m_boundary.m_top_left_front;
+    while (!m_nodes[home].is_leaf()) {
+        const node& current = m_nodes[home];
+        const glm::vec3& child_size = m_cell_sizes[current.level + 1];
+        const glm::vec3 mid = home_min + child_size;
+        const uint64_t octant = (uint64_t)(point.x >= mid.x) | (uint64_t)(point.y >= mid.y) << 1 | (uint64_t)(point.z >= mid.z) << 2;
+        const uint32_t children_end = current.first_child + current.get_child_count();
+        uint32_t child = current.first_child;
+        while (child < children_end && (m_nodes[child].code & 7) != octant) {
+            ++child;
+        }
+        if (child == children_end || (m_nodes[child].get_point_count() < k && m_nodes[home].get_point_count() <= max_home_points)) {
+            break;
+        }
+        home = child;
+        home_min = get_child_min(home_min, octant, child_size);
+    }
+    const bool is_home_small = m_nodes[home].get_point_count() <= max_home_points;
+    const uint32_t home_begin = is_home_small ? m_nodes[home].point_begin : 0;
+    const uint32_t home_end = is_home_small ? m_nodes[home].point_end : 0;
+    scan_points(home_begin, home_end);
+    auto is_scanned = [&](const node& node) { return node.point_begin >= home_begin && node.point_end <= home_end; };
+
+    auto& queue = buffer.entries;
+    queue.clear();
+    if (home_end - home_begin < m_nodes[0].get_point_count()) {
+        queue.push_back({get_box_squared_distance(point, m_boundary.m_top_left_front, m_cell_sizes[0]), 0, m_boundary.m_top_left_front});
+    }
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), is_farther_entry);
+        const search_buffer::entry entry = queue.back();
+        queue.pop_back();
+        if (neighbors.size() == k && entry.squared_distance > neighbors.front().squared_distance) {
+            break;
+        }
+        // the leaf children are scanned right away, only the internal ones and a leaf root go through the queue
+        const node& current = m_nodes[entry.node];
+        if (current.is_leaf()) {
+            scan_points(current.point_begin, current.point_end);
+            continue;
+        }
+        const glm::vec3& child_size = m_cell_sizes[current.level + 1];
+        const uint32_t children_end = current.first_child + current.get_child_count();
+        for (uint32_t child = current.first_child; child < children_end; ++child) {
+            if (is_scanned(m_nodes[child])) {
+                continue;
+            }
+            const glm::vec3 child_min = get_child_min(entry.min, m_nodes[child].code, child_size);
+            const float squared_distance = get_box_squared_distance(point, child_min, child_size);
+            if (neighbors.size() == k && squared_distance > neighbors.front().squared_distance) {
+                continue;
+            }
+            if (m_nodes[child].is_leaf()) {
+                scan_points(m_nodes[child].point_begin, m_nodes[child].point_end);
+            } else {
+                queue.push_back({squared_distance, child, child_min});
+                std::push_heap(queue.begin(), queue.end(), is_farther_entry);
+            }
+        }
+    }
+    std::sort_heap(neighbors.begin(), neighbors.end(), is_closer_neighbor);
+}
+
+void linear_octree::radius(const glm::vec3& point, const float search_radius, std::vector<neighbor>& neighbors, search_buffer& buffer) const {
+    neighbors.clear();
+    if (empty()) {
+        return;
+    }
+    // the order does not matter here, so depth first with a plain stack
+    const float squared_radius = search_radius * search_radius;
+    auto& stack = buffer.entries;
+    stack.clear();
+    if (get_box_squared_distance(point, m_boundary.m_top_left_front, m_cell_sizes[0]) <= squared_radius) {
+        stack.push_back({0.0f, 0, m_boundary.m_top_left_front});
+    }
+    while (!stack.empty()) {
+        const search_buffer::entry entry = stack.back();
+        stack.pop_back();
+        const node& current = m_nodes[entry.node];
+        if (current.is_leaf()) {
+            const uint32_t count = current.get_point_count();
+            buffer.distances.resize(count);
+            const float* x = m_x.data() + current.point_begin;
+            const float* y = m_y.data() + current.point_begin;
+            const float* z = m_z.data() + current.point_begin;
+            for (uint32_t i = 0; i < count; ++i) {
+                const float dx = x[i] - point.x;
+                const float dy = y[i] - point.y;
+                const float dz = z[i] - point.z;
+                buffer.distances[i] = dx * dx + dy * dy + dz * dz;
+            }
+            for (uint32_t i = 0; i < count; ++i) {
+                if (buffer.distances[i] <= squared_radius) {
+                    neighbors.push_back({m_point_indices[current.point_begin + i], buffer.distances[i]});
+                }
+            }
+            continue;
+        }
+        const glm::vec3& child_size = m_cell_sizes[current.level + 1];
+        const uint32_t children_end = current.first_child + current.get_child_count();
+        for (uint32_t child = current.first_child; child < children_end; ++child) {
+            const glm::vec3 child_min = get_child_min(entry.min, m_nodes[child].code, child_size);
+            if (get_box_squared_distance(point, child_min, child_size) <= squared_radius) {
+                stack.push_back({0.0f, child, child_min});
+            }
+        }
+    }
+}
+
+template <typename Query>
+void linear_octree::query(const point_cloud& queries, neighbor_lists& lists, size_t thread_count, const Query& query) const {
+    thread_count = get_thread_count(thread_count, queries.size(), parallel_query_count);
+    lists.offsets.assign(queries.size() + 1, 0);
+    // every thread collects the neighbors of its contiguous slice of queries, then copies them to their place
+    std::vector<std::vector<neighbor>> thread_neighbors(thread_count);
+    parallel_for(thread_count, queries.size(), [&](const size_t begin, const size_t end, const size_t t) {
+        search_buffer buffer;
+        std::vector<neighbor> neighbors;
+        for (size_t i = begin; i < end; ++i) {
+            if (queries.is_valid(i)) {
+                query(queries.get_position(i), neighbors, buffer);
+                thread_neighbors[t].insert(thread_neighbors[t].end(), neighbors.begin(), neighbors.end());
+                lists.offsets[i + 1] = neighbors.size();
+            }
+        }
+    });
+    for (size_t i = 0; i < queries.size(); ++i) {
+        lists.offsets[i + 1] += lists.offsets[i];
+    }
+    lists.neighbors.resize(lists.offsets.back());
+    parallel_for(thread_count, queries.size(), [&](const size_t begin, size_t, const size_t t) {
+        std::copy(thread_neighbors[t].begin(), thread_neighbors[t].end(), lists.neighbors.begin() + lists.offsets[begin]);
+    });
+}
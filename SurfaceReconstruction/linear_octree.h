@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "octree.h"
+#include "point_cloud.h"
+
+// octree without pointers, built in bulk: the valid points get 63 bit Morton codes (21 bits per axis) relative to their
+// bounds, are radix sorted by code, and every node is a contiguous range of the sorted points. The children of a node
+// are stored next to each other, so a node only needs the index of its first child and a mask of the octants present.
+class linear_octree {
+public:
+    static constexpr int max_level = 21;
+
+    struct node {
+        // the Morton code of the cell, level * 3 bits
+        uint64_t code = 0;
+        uint32_t first_child = 0;
+        uint32_t point_begin = 0;
+        uint32_t point_end = 0;
+        uint8_t child_mask = 0;
+        uint8_t level = 0;
+
+        bool is_leaf() const { return child_mask == 0; }
+        uint32_t get_point_count() const { return point_end - point_begin; }
+        int get_child_count() const;
+    };
+
+    struct neighbor {
+        // the point_cloud index of the point
+        uint32_t index = 0;
+        float squared_distance = 0.0f;
+    };
+
+    // the neighbors of a batch of queries, those of query i are neighbors[offsets[i], offsets[i + 1])
+    struct neighbor_lists {
+        std::vector<size_t> offsets;
+        std::vector<neighbor> neighbors;
+
+        size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+        size_t get_count(const size_t i) const { return offsets[i + 1] - offsets[i]; }
+        const neighbor* get_neighbors(const size_t i) const { return neighbors.data() + offsets[i]; }
+    };
+
+    struct build_statistics {
+        // the points in the tree
+        size_t points = 0;
+        // the exact repeats of a point already in the tree, and the invalid (0, 0, 0) points
+        size_t duplicate_points = 0;
+        size_t skipped_points = 0;
+        size_t nodes = 0;
+        double code_seconds = 0.0;
+        double sort_seconds = 0.0;
+        double node_seconds = 0.0;
+    };
+
+    // a node is split while it holds more than leaf_capacity points and is above max_depth (clamped to max_level), so
+    // the leaves at max_depth can hold more. The invalid (0, 0, 0) points are left out, and of the points at exactly the
+    // same position only the one with the lowest index is kept. With rejected_indices the cloud indices of the left out
+    // points are appended to it in increasing order.
+    // thread_count 0: one per hardware thread, small clouds are built on the calling thread.
+    void build(const point_cloud& points, size_t leaf_capacity = 8, int max_depth = max_level, size_t thread_count = 0,
+               build_statistics* statistics = nullptr, std::vector<uint32_t>* rejected_indices = nullptr);
+    void clear();
+
+    bool empty() const { return m_nodes.empty(); }
+    const std::vector<node>& get_nodes() const { return m_nodes; }
+    const node& get_root() const { return m_nodes.front(); }
+    // the point_cloud indices of the points of a node are m_point_indices[point_begin, point_end)
+    const std::vector<uint32_t>& get_point_indices() const { return m_point_indices; }
+    const octree::boundary& get_boundary() const { return m_boundary; }
+    int get_max_depth() const { return m_max_depth; }
+    octree::boundary get_node_boundary(const node& node) const;
+    size_t get_memory_size() const;
+
+    // best first: the nodes are visited in the order of their box distance, the search stops at the first box farther
+    // than the k-th point found. The neighbors are sorted closest first, a point of the tree is its own first neighbor.
+    void knn(const glm::vec3& point, size_t k, std::vector<neighbor>& neighbors) const;
+    // the points within search_radius in no particular order, the nodes whose box is farther are skipped
+    void radius(const glm::vec3& point, float search_radius, std::vector<neighbor>& neighbors) const;
+    // one query per point of queries, split across the threads like build, invalid query points get no neighbors
+    void knn(const point_cloud& queries, size_t k, neighbor_lists& lists, size_t thread_count = 0) const;
+    void radius(const point_cloud& queries, float search_radius, neighbor_lists& lists, size_t thread_count = 0) const;
+
+    static uint64_t get_morton_code(uint32_t x, uint32_t y, uint32_t z);
+
+private:
+    struct search_buffer;
+
+    void knn(const glm::vec3& point, size_t k, std::vector<neighbor>& neighbors, search_buffer& buffer) const;
+    void radius(const glm::vec3& point, float search_radius, std::vector<neighbor>& neighbors, search_buffer& buffer) const;
+    template <typename Query>
+    void query(const point_cloud& queries, neighbor_lists& lists, size_t thread_count, const Query& query) const;
+
+    octree::boundary m_boundary{};
+    int m_max_depth = 0;
+    // the size of a cell at every level down to m_max_depth
+    glm::vec3 m_cell_sizes[max_level + 1]{};
+    std::vector<node> m_nodes;
+    std::vector<uint32_t> m_point_indices;
+    // the positions in the order of m_point_indices, so the points of a leaf are next to each other for the distance scans
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    // the build's scratch space, kept so a rebuild reuses it: the Morton codes of the sorted points and the radix sort buffers
+    std::vector<uint64_t> m_codes;
+    std::vector<uint64_t> m_code_buffer;
+    std::vector<uint32_t> m_index_buffer;
+    std::vector<size_t> m_histograms;
+};
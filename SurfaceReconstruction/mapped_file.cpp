@@ -0,0 +1,142 @@
+#include <iostream>
+#include <utility>
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+mapped_file::mapped_file(const std::string& filename) {
+    open(filename);
+}
+
+mapped_file::~mapped_file() {
+    close();
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept {
+    *this = std::move(other);
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+    if (&other == this)
+        return *this;
+
+    close();
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_is_open_empty, other.m_is_open_empty);
+#ifdef _WIN32
+    std::swap(m_file_handle, other.m_file_handle);
+    std::swap(m_mapping_handle, other.m_mapping_handle);
+#else
+    std::swap(m_file_descriptor, other.m_file_descriptor);
+#endif
+    return *this;
+}
+
+#ifdef _WIN32
+bool mapped_file::open(const std::string& filename) {
+    close();
+
+    const HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Could not open file: " << filename << std::endl;
+        return false;
+    }
+    m_file_handle = file;
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        std::cerr << "Could not query size of file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    if (file_size.QuadPart == 0) {
+        // zero length files cannot be mapped, but they are valid inputs
+        m_is_open_empty = true;
+        return true;
+    }
+
+    const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        std::cerr << "Could not map file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    m_mapping_handle = mapping;
+
+    m_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == nullptr) {
+        std::cerr << "Could not map view of file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    m_size = static_cast<size_t>(file_size.QuadPart);
+    return true;
+}
+
+void mapped_file::close() {
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if (m_mapping_handle != nullptr)
+        CloseHandle(m_mapping_handle);
+    if (m_file_handle != nullptr)
+        CloseHandle(m_file_handle);
+    m_data = nullptr;
+    m_size = 0;
+    m_is_open_empty = false;
+    m_mapping_handle = nullptr;
+    m_file_handle = nullptr;
+}
+#else
+bool mapped_file::open(const std::string& filename) {
+    close();
+
+    m_file_descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (m_file_descriptor < 0) {
+        std::cerr << "Could not open file: " << filename << std::endl;
+        return false;
+    }
+
+    struct stat file_stat{};
+    if (fstat(m_file_descriptor, &file_stat) != 0) {
+        std::cerr << "Could not query size of file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    if (file_stat.st_size == 0) {
+        m_is_open_empty = true;
+        return true;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, m_file_descriptor, 0);
+    if (data == MAP_FAILED) {
+        std::cerr << "Could not map file: " << filename << std::endl;
+        close();
+        return false;
+    }
+    madvise(data, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+    m_data = static_cast<const char*>(data);
+    m_size = static_cast<size_t>(file_stat.st_size);
+    return true;
+}
+
+void mapped_file::close() {
+    if (m_data != nullptr)
+        munmap(const_cast<char*>(m_data), m_size);
+    if (m_file_descriptor >= 0)
+        ::close(m_file_descriptor);
+    m_data = nullptr;
+    m_size = 0;
+    m_is_open_empty = false;
+    m_file_descriptor = -1;
+}
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// read-only memory mapping of a whole file, unmapped on destruction
+class mapped_file {
+public:
+    mapped_file() = default;
+    explicit mapped_file(const std::string& filename);
+    ~mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+
+    bool open(const std::string& filename);
+    void close();
+
+    bool is_open() const { return m_data != nullptr || m_is_open_empty; }
+    const char* data() const { return m_data; }
+    const char* begin() const { return m_data; }
+    const char* end() const { return m_data + m_size; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_is_open_empty = false;
+#ifdef _WIN32
+    void* m_file_handle = nullptr;
+    void* m_mapping_handle = nullptr;
+#else
+    int m_file_descriptor = -1;
+#endif
+};
@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include "Includes/json.hpp"
+#include "mesh_exporter.h"
+
+namespace {
+    // collects small writes into a large buffer, the file only sees buffer sized writes. The file is written next to
+    // the final path and renamed in close, so a crash never leaves a truncated mesh behind.
+    class buffered_writer {
+    public:
+        static constexpr size_t max_buffer_size = 8 << 20;
+
+        // the buffer is only as large as the expected output, batch exports of small frames do not pay for 8 MB
+        buffered_writer(const std::string& filename, const size_t expected_size)
+            : m_filename(filename), m_file(filename + ".tmp", std::ios::binary | std::ios::trunc),
+              m_buffer_size(std::clamp(expected_size, (size_t)65536, max_buffer_size)), m_buffer(new char[m_buffer_size]) {}
+
+        ~buffered_writer() {
+            if (m_file.is_open()) {
+                m_file.close();
+                std::error_code error;
+                std::filesystem::remove(m_filename + ".tmp", error);
+            }
+        }
+
+        bool is_open() const { return m_file.is_open(); }
+        size_t get_written_size() const { return m_written_size + m_used; }
+
+        // room for at most size bytes, handed back through commit
+        char* reserve(const size_t size) {
+            if (m_used + size > m_buffer_size) {
+                flush();
+            }
+            return m_buffer.get() + m_used;
+        }
+
+        void commit(const size_t size) { m_used += size; }
+
+        void write(const void* data, const size_t size) {
+            if (size > m_buffer_size) {
+                flush();
+                m_file.write((const char*)data, size);
+                m_written_size += size;
+                return;
+            }
+            std::memcpy(reserve(size), data, size);
+            m_used += size;
+        }
+
+        void write(const std::string& text) { write(text.data(), text.size()); }
+
+        template <typename T>
+        void put(const T value) { write(&value, sizeof(value)); }
+
+        bool close() {
+            flush();
+            m_file.close();
+            const std::string temporary_path = m_filename + ".tmp";
+            std::error_code error;
+            if (m_file.fail()) {
+                std::cerr << "Could not write file: " << temporary_path << std::endl;
+                std::filesystem::remove(temporary_path, error);
+                return false;
+            }
+            std::filesystem::rename(temporary_path, m_filename, error);
+            if (error) {
+                std::cerr << "Could not move " << temporary_path << " to " << m_filename << ": " << error.message() << std::endl;
+                std::filesystem::remove(temporary_path, error);
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        void flush() {
+            m_file.write(m_buffer.get(), m_used);
+            m_written_size += m_used;
+            m_used = 0;
+        }
+
+        std::string m_filename;
+        std::ofstream m_file;
+        size_t m_buffer_size;
+        std::unique_ptr<char[]> m_buffer;
+        size_t m_used = 0;
+        size_t m_written_size = 0;
+    };
+
+    uint8_t to_color_byte(const float value) {
+        return (uint8_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    std::string get_extension(const std::string& filename) {
+        std::string extension = std::filesystem::path(filename).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char c) { return (char)std::tolower(c); });
+        return extension;
+    }
+
+    bool finish(buffered_writer& writer, const size_t vertex_count, const size_t triangle_count,
+                const std::chrono::steady_clock::time_point start_time, mesh_exporter::export_statistics* statistics) {
+        const size_t bytes = writer.get_written_size();
+        if (!writer.close()) {
+            return false;
+        }
+        if (statistics != nullptr) {
+            statistics->vertices = vertex_count;
+            statistics->triangles = triangle_count;
+            statistics->bytes = bytes;
+            statistics->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+        }
+        return true;
+    }
+}
+
+bool mesh_exporter::is_supported_file(const std::string& filename) {
+    const std::string extension = get_extension(filename);
+    return extension == ".ply" || extension == ".obj" || extension == ".gltf" || extension == ".glb";
+}
+
+bool mesh_exporter::write_mesh(const std::string& filename, const std::vector<file_loader::vertex>& vertices, const std::vector<int>& indices, export_statistics* statistics) {
+    const std::string extension = get_extension(filename);
+    if (extension == ".ply") {
+        return write_ply(filename, vertices, indices, statistics);
+    }
+    if (extension == ".obj") {
+        return write_obj(filename, vertices, indices, statistics);
+    }
+    if (extension == ".gltf" || extension == ".glb") {
+        return write_gltf(filename, vertices, indices, statistics);
+    }
+    std::cerr << "Unsupported mesh format: " << filename << std::endl;
+    return false;
+}
+
+bool mesh_exporter::compact(const std::vector<file_loader::vertex>& vertices, const std::vector<int>& indices, compact_mesh& mesh) {
+    if (indices.size() % 3 != 0) {
+        std::cerr << "Error: the index count " << indices.size() << " is not a multiple of 3" << std::endl;
+        return false;
+    }
+    constexpr uint32_t unused = UINT32_MAX;
+    std::vector<uint32_t> remap(vertices.size(), unused);
+    for (const int index : indices) {
+        if (index < 0 || (size_t)index >= vertices.size()) {
+            std::cerr << "Error: mesh index " << index << " is out of range" << std::endl;
+            return false;
+        }
+        remap[index] = 0;
+    }
+
+    mesh.vertex_indices.clear();
+    for (size_t i = 0; i < remap.size(); ++i) {
+        if (remap[i] != unused) {
+            remap[i] = (uint32_t)mesh.vertex_indices.size();
+            mesh.vertex_indices.push_back((uint32_t)i);
+        }
+    }
+    mesh.indices.resize(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        mesh.indices[i] = remap[indices[i]];
+    }
+    return true;
+}
+
+bool mesh_exporter::write_ply(const std::string& filename, const std::vector<file_loader::vertex>& vertices, const std::vector<int>& indices, export_statistics* statistics) {
+    const auto start_time = std::chrono::steady_clock::now();
+    compact_mesh mesh;
+    if (!compact(vertices, indices, mesh)) {
+        return false;
+    }
+    const size_t triangle_count = mesh.indices.size() / 3;
+    buffered_writer writer(filename, 512 + mesh.vertex_indices.size() * 15 + triangle_count * 13);
+    if (!writer.is_open()) {
+        std::cerr << "Could not open file: " << filename << std::endl;
+        return false;
+    }
+
+    writer.write("ply\nformat binary_little_endian 1.0\ncomment SurfaceReconstruction\n"
+                 "element vertex " + std::to_string(mesh.vertex_indices.size()) + "\n"
+                 "property float x\nproperty float y\nproperty float z\n"
+                 "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+                 "element face " + std::to_string(triangle_count) + "\n"
+                 "property list uchar int vertex_indices\nend_header\n");
+
+    // records are copied as they are in memory, the targets are little endian
+    constexpr size_t vertex_record_size = 3 * sizeof(float) + 3;
+    for (const uint32_t vertex_index : mesh.vertex_indices) {
+        const file_loader::vertex& vertex = vertices[vertex_index];
+        char* record = writer.reserve(vertex_record_size);
+        std::memcpy(record, &vertex.position[0], 3 * sizeof(float));
+        record[12] = (char)to_color_byte(vertex.color.r);
+        record[13] = (char)to_color_byte(vertex.color.g);
+        record[14] = (char)to_color_byte(vertex.color.b);
+        writer.commit(vertex_record_size);
+    }
+    constexpr size_t face_record_size = 1 + 3 * sizeof(uint32_t);
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        char* record = writer.reserve(face_record_size);
+        record[0] = 3;
+        std::memcpy(record + 1, &mesh.indices[i], 3 * sizeof(uint32_t));
+        writer.commit(face_record_size);
+    }
+    return finish(writer, mesh.vertex_indices.size(), triangle_count, start_time, statistics);
+}
+
+bool mesh_exporter::write_obj(const std::string& filename, const std::vector<file_loader::vertex>& vertices, const std::vector<int>& indices, export_statistics* statistics) {
+    const auto start_time = std::chrono::steady_clock::now();
+    compact_mesh mesh;
+    if (!compact(vertices, indices, mesh)) {
+        return false;
+    }
+    buffered_writer writer(filename, mesh.vertex_indices.size() * 64 + mesh.indices.size() * 8);
+    if (!writer.is_open()) {
+        std::cerr << "Could not open file: " << filename << std::endl;
+        return false;
+    }
+
+    writer.write("# SurfaceReconstruction\n");
+    // "v " + 3 shortest floats + 3 colors with 3 decimals stay well below this
+    constexpr size_t max_line_size = 128;
+    for (const uint32_t vertex_index : mesh.vertex_indices) {
+        const file_loader::vertex& vertex = vertices[vertex_index];
+        char* const line = writer.reserve(max_line_size);
+        char* it = line;
+        char* const end = line + max_line_size;
+        *it++ = 'v';
+        for (int axis = 0; axis < 3; ++axis) {
+            *it++ = ' ';
+            it = std::to_chars(it, end, vertex.position[axis]).ptr;
+        }
+        for (int channel = 0; channel < 3; ++channel) {
+            *it++ = ' ';
+            it = std::to_chars(it, end, to_color_byte(vertex.color[channel]) / 255.0f, std::chars_format::fixed, 3).ptr;
+        }
+        *it++ = '\n';
+        writer.commit(it - line);
+    }
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        char* const line = writer.reserve(max_line_size);
+        char* it = line;
+        char* const end = line + max_line_size;
+        *it++ = 'f';
+        for (int corner = 0; corner < 3; ++corner) {
+            *it++ = ' ';
+            it = std::to_chars(it, end, mesh.indices[i + corner] + 1).ptr;
+        }
+        *it++ = '\n';
+        writer.commit(it - line);
+    }
+    return finish(writer, mesh.vertex_indices.size(), mesh.indices.size() / 3, start_time, statistics);
+}
+
+bool mesh_exporter::write_gltf(const std::string& filename, const std::vector<file_loader::vertex>& vertices, const std::vector<int>& indices, export_statistics* statistics) {
+    const auto start_time = std::chrono::steady_clock::now();
+    compact_mesh mesh;
+    if (!compact(vertices, indices, mesh)) {
+        return false;
+    }
+    const bool is_binary = get_extension(filename) == ".glb";
+    const size_t vertex_count = mesh.vertex_indices.size();
+    const size_t triangle_count = mesh.indices.size() / 3;
+
+    // one buffer: positions, rgba colors, indices, every view stays 4 byte aligned
+    const size_t positions_size = vertex_count * 3 * sizeof(float);
+    const size_t colors_size = vertex_count * 4;
+    const size_t indices_size = mesh.indices.size() * sizeof(uint32_t);
+    const size_t buffer_size = positions_size + colors_size + indices_size;
+
+    nlohmann::json gltf = {
+        {"asset", {{"version", "2.0"}, {"generator", "SurfaceReconstruction"}}},
+        {"scene", 0},
+        {"scenes", {{{"nodes", {0}}}}},
+        {"nodes", {{{"rotation", {-0.70710678, 0.0, 0.0, 0.70710678}}}}}
+    };
+    const std::string bin_file = std::filesystem::path(filename).replace_extension(".bin").string();
+    if (triangle_count > 0) {
+        glm::vec3 min = vertices[mesh.vertex_indices[0]].position;
+        glm::vec3 max = min;
+        for (const uint32_t vertex_index : mesh.vertex_indices) {
+            min = glm::min(min, vertices[vertex_index].position);
+            max = glm::max(max, vertices[vertex_index].position);
+        }
+        gltf["nodes"][0]["mesh"] = 0;
+        gltf["meshes"] = {{{"primitives", {{{"attributes", {{"POSITION", 0}, {"COLOR_0", 1}}}, {"indices", 2}, {"mode", 4}}}}}};
+        gltf["buffers"] = {{{"byteLength", buffer_size}}};
+        if (!is_binary) {
+            gltf["buffers"][0]["uri"] = std::filesystem::path(bin_file).filename().string();
+        }
+        gltf["bufferViews"] = {
+            {{"buffer", 0}, {"byteOffset", 0}, {"byteLength", positions_size}, {"target", 34962}},
+            {{"buffer", 0}, {"byteOffset", positions_size}, {"byteLength", colors_size}, {"target", 34962}},
+            {{"buffer", 0}, {"byteOffset", positions_size + colors_size}, {"byteLength", indices_size}, {"target", 34963}}
+        };
+        gltf["accessors"] = {
+            {{"bufferView", 0}, {"componentType", 5126}, {"count", vertex_count}, {"type", "VEC3"}, {"min", {min.x, min.y, min.z}}, {"max", {max.x, max.y, max.z}}},
+            {{"bufferView", 1}, {"componentType", 5121}, {"normalized", true}, {"count", vertex_count}, {"type", "VEC4"}},
+            {{"bufferView", 2}, {"componentType", 5125}, {"count", mesh.indices.size()}, {"type", "SCALAR"}}
+        };
+    }
+    std::string json = gltf.dump();
+
+    if (is_binary || triangle_count > 0) {
+        buffered_writer writer(is_binary ? filename : bin_file, json.size() + buffer_size + 28);
+        if (!writer.is_open()) {
+            std::cerr << "Could not open file: " << (is_binary ? filename : bin_file) << std::endl;
+            return false;
+        }
+        if (is_binary) {
+            json.resize((json.size() + 3) & ~(size_t)3, ' ');
+            const bool has_buffer = triangle_count > 0;
+            writer.write("glTF", 4);
+            writer.put((uint32_t)2);
+            writer.put((uint32_t)(12 + 8 + json.size() + (has_buffer ? 8 + buffer_size : 0)));
+            writer.put((uint32_t)json.size());
+            writer.write("JSON", 4);
+            writer.write(json);
+            if (has_buffer) {
+                writer.put((uint32_t)buffer_size);
+                writer.write("BIN\0", 4);
+            }
+        }
+
+        if (triangle_count > 0) {
+            for (const uint32_t vertex_index : mesh.vertex_indices) {
+                writer.write(&vertices[vertex_index].position[0], 3 * sizeof(float));
+            }
+            for (const uint32_t vertex_index : mesh.vertex_indices) {
+                const glm::vec3& color = vertices[vertex_index].color;
+                char* rgba = writer.reserve(4);
+                rgba[0] = (char)to_color_byte(color.r);
+                rgba[1] = (char)to_color_byte(color.g);
+                rgba[2] = (char)to_color_byte(color.b);
+                rgba[3] = (char)255;
+                writer.commit(4);
+            }
+            writer.write(mesh.indices.data(), indices_size);
+        }
+        if (!finish(writer, vertex_count, triangle_count, start_time, statistics)) {
+            return false;
+        }
+        if (is_binary) {
+            return true;
+        }
+    }
+
+    // the .gltf refers to the .bin, so it is only written once the buffer is in place
+    buffered_writer json_writer(filename, json.size());
+    if (!json_writer.is_open()) {
+        std::cerr << "Could not open file: " << filename << std::endl;
+        return false;
+    }
+    json_writer.write(json);
+    export_statistics json_statistics;
+    if (!finish(json_writer, vertex_count, triangle_count, start_time, &json_statistics)) {
+        return false;
+    }
+    if (statistics != nullptr) {
+        json_statistics.bytes += triangle_count > 0 ? statistics->bytes : 0;
+        *statistics = json_statistics;
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "file_loader.h"
+
+// writes triangle meshes over the ring ordered points (binary PLY, OBJ, glTF / GLB). Vertices no triangle refers to
+// are left out, everything goes through one large buffer so a frame is a handful of writes.
+class mesh_exporter {
+public:
+    struct export_statistics {
+        size_t vertices = 0;
+        size_t triangles = 0;
+        size_t bytes = 0;
+        double seconds = 0.0;
+    };
+
+    // picks the format from the extension: .ply, .obj, .gltf (with a .bin next to it) or .glb
+    static bool write_mesh(const std::string& filename, const std::vector<file_loader::vertex>& vertices, const std::vector<int>& indices, export_statistics* statistics = nullptr);
+    static bool is_supported_file(const std::string& filename);
+
+    // binary little endian PLY with uchar colors
+    static bool write_ply(const std::string& filename, const std::vector<file_loader::vertex>& vertices, const std::vector<int>& indices, export_statistics* statistics = nullptr);
+    // text OBJ, colors follow the positions on the v lines (read by MeshLab, CloudCompare and Blender)
+    static bool write_obj(const std::string& filename, const std::vector<file_loader::vertex>& vertices, const std::vector<int>& indices, export_statistics* statistics = nullptr);
+    // glTF 2.0 with POSITION, COLOR_0 and uint32 indices, a single .glb if the extension is .glb. The node is rotated
+    // so the lidar z axis points up in the y up glTF frame.
+    static bool write_gltf(const std::string& filename, const std::vector<file_loader::vertex>& vertices, const std::vector<int>& indices, export_statistics* statistics = nullptr);
+
+private:
+    // the referenced vertices in their original order and the triangles indexing into them
+    struct compact_mesh {
+        std::vector<uint32_t> vertex_indices;
+        std::vector<uint32_t> indices;
+    };
+
+    static bool compact(const std::vector<file_loader::vertex>& vertices, const std::vector<int>& indices, compact_mesh& mesh);
+};
@@ -0,0 +1,25 @@
+#include <iostream>
+#include "obj_parser_benchmark.h"
+
+// obj-parser-bench: the obj parser comparison of the viewer without opening a window, the meshes are never uploaded
+
+int main(const int argc, char** argv) {
+    if (argc < 2) {
+        std::cout << "usage: obj-parser-bench <file.obj>..." << std::endl;
+        return 1;
+    }
+    int exit_code = 0;
+    for (int i = 1; i < argc; ++i) {
+        obj_parser_benchmark::result result;
+        if (!obj_parser_benchmark::run(argv[i], result)) {
+            exit_code = 1;
+            continue;
+        }
+        std::cout << argv[i] << ": ";
+        obj_parser_benchmark::print(result);
+        if (!result.is_identical) {
+            exit_code = 1;
+        }
+    }
+    return exit_code;
+}
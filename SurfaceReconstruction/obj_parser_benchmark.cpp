@@ -0,0 +1,45 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include "obj_parser_benchmark.h"
+#include "Includes/ObjParser_OGL3.h"
+
+bool obj_parser_benchmark::run(const std::string& filename, result& result) {
+    const auto parse_timed = [&filename](Mesh* (*parse)(const char*), double& seconds) -> std::unique_ptr<Mesh> {
+        const auto start_time = std::chrono::steady_clock::now();
+        try {
+            std::unique_ptr<Mesh> mesh(parse(filename.c_str()));
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+            return mesh;
+        } catch (ObjParser::Exception) {
+            std::cerr << "Could not parse obj file: " << filename << std::endl;
+            return {};
+        }
+    };
+
+    const auto stream_mesh = parse_timed(ObjParser::parseStream, result.stream_seconds);
+    const auto mapped_mesh = parse_timed(ObjParser::parse, result.mapped_seconds);
+    if (!stream_mesh || !mapped_mesh) {
+        return false;
+    }
+
+    // the stream parser drops everything after the third corner of a polygon, so only triangle meshes compare equal
+    const auto& stream_vertices = stream_mesh->getVertices();
+    const auto& mapped_vertices = mapped_mesh->getVertices();
+    result.vertices = mapped_vertices.size();
+    result.triangles = mapped_mesh->getIndices().size() / 3;
+    result.is_identical = stream_mesh->getIndices() == mapped_mesh->getIndices() &&
+        stream_vertices.size() == mapped_vertices.size() &&
+        std::equal(stream_vertices.begin(), stream_vertices.end(), mapped_vertices.begin(),
+                   [](const Mesh::Vertex& a, const Mesh::Vertex& b) {
+                       return a.position == b.position && a.normal == b.normal && a.texcoord == b.texcoord;
+                   });
+    return true;
+}
+
+void obj_parser_benchmark::print(const result& result) {
+    std::cout << "ifstream obj parser: " << result.stream_seconds * 1000.0 << " ms, mapped obj parser: " << result.mapped_seconds * 1000.0
+        << " ms (" << result.vertices << " vertices, " << result.triangles << " triangles), "
+        << "speedup: " << result.speedup() << "x, identical output: " << (result.is_identical ? "yes" : "no") << std::endl;
+}
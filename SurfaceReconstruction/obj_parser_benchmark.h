@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+
+// times the original ifstream obj parser against the memory mapped one on the same file and checks that they build
+// the same mesh, used by the viewer and the obj-parser-bench tool
+class obj_parser_benchmark {
+public:
+    struct result {
+        double stream_seconds = 0.0;
+        double mapped_seconds = 0.0;
+        size_t vertices = 0;
+        size_t triangles = 0;
+        bool is_identical = false;
+
+        double speedup() const {
+            return mapped_seconds > 0.0 ? stream_seconds / mapped_seconds : 0.0;
+        }
+    };
+
+    // false if either parser fails on the file
+    static bool run(const std::string& filename, result& result);
+    static void print(const result& result);
+};
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cmath>
+#include "point_cloud.h"
+
+point_cloud::point_cloud(const size_t size) {
+    resize(size);
+}
+
+point_cloud point_cloud::from_vertices(const std::vector<file_loader::vertex>& vertices, const bool keep_colors) {
+    point_cloud points(vertices.size());
+    if (keep_colors) {
+        points.enable_colors();
+    }
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        points.set_vertex(i, vertices[i]);
+    }
+    return points;
+}
+
+std::vector<file_loader::vertex> point_cloud::to_vertices() const {
+    std::vector<file_loader::vertex> vertices(size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i] = get_vertex(i);
+    }
+    return vertices;
+}
+
+void point_cloud::resize(const size_t size) {
+    m_x.resize(size, 0.0f);
+    m_y.resize(size, 0.0f);
+    m_z.resize(size, 0.0f);
+    m_intensities.resize(size, 0);
+    if (m_has_colors) {
+        m_colors.resize(size, glm::vec3(0.0f));
+    }
+    if (m_has_normals) {
+        m_normals.resize(size, glm::vec3(0.0f));
+    }
+    if (m_has_mask) {
+        m_mask.resize(size, 0);
+    }
+}
+
+void point_cloud::clear() {
+    resize(0);
+}
+
+void point_cloud::reserve(const size_t capacity) {
+    m_x.reserve(capacity);
+    m_y.reserve(capacity);
+    m_z.reserve(capacity);
+    m_intensities.reserve(capacity);
+    if (m_has_colors) {
+        m_colors.reserve(capacity);
+    }
+    if (m_has_normals) {
+        m_normals.reserve(capacity);
+    }
+    if (m_has_mask) {
+        m_mask.reserve(capacity);
+    }
+}
+
+void point_cloud::push_back(const glm::vec3& position, const uint16_t intensity, const glm::vec3& color) {
+    m_x.push_back(position.x);
+    m_y.push_back(position.y);
+    m_z.push_back(position.z);
+    m_intensities.push_back(intensity);
+    if (m_has_colors) {
+        m_colors.push_back(color);
+    }
+    if (m_has_normals) {
+        m_normals.emplace_back(0.0f);
+    }
+    if (m_has_mask) {
+        m_mask.push_back(0);
+    }
+}
+
+file_loader::vertex point_cloud::get_vertex(const size_t i) const {
+    return {get_position(i), m_has_colors ? m_colors[i] : glm::vec3(m_intensities[i]), (float)m_intensities[i]};
+}
+
+void point_cloud::set_vertex(const size_t i, const file_loader::vertex& vertex) {
+    set_position(i, vertex.position);
+    if (m_has_colors) {
+        m_colors[i] = vertex.color;
+    }
+    m_intensities[i] = (uint16_t)std::clamp((int)std::lround(vertex.intensity), 0, 65535);
+}
+
+void point_cloud::enable_colors() {
+    m_has_colors = true;
+    m_colors.resize(size(), glm::vec3(0.0f));
+}
+
+void point_cloud::enable_normals() {
+    m_has_normals = true;
+    m_normals.resize(size(), glm::vec3(0.0f));
+}
+
+void point_cloud::enable_mask() {
+    m_has_mask = true;
+    m_mask.resize(size(), 0);
+}
+
+size_t point_cloud::get_memory_size() const {
+    return (m_x.capacity() + m_y.capacity() + m_z.capacity()) * sizeof(float) + m_intensities.capacity() * sizeof(uint16_t) +
+        (m_colors.capacity() + m_normals.capacity()) * sizeof(glm::vec3) + m_mask.capacity();
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <glm/glm.hpp>
+#include "file_loader.h"
+
+// std::allocator with over-aligned storage, so vectorized loops can start on a cache line
+template <typename T, size_t Alignment>
+struct aligned_allocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = aligned_allocator<U, Alignment>;
+    };
+
+    aligned_allocator() = default;
+    template <typename U>
+    aligned_allocator(const aligned_allocator<U, Alignment>&) {}
+
+    T* allocate(const size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* pointer, size_t) {
+        ::operator delete(pointer, std::align_val_t(Alignment));
+    }
+
+    bool operator==(const aligned_allocator&) const { return true; }
+    bool operator!=(const aligned_allocator&) const { return false; }
+};
+
+// points as a structure of arrays: x, y, z and a 16 bit intensity each in their own cache line aligned array, colors,
+// normals and a mask only when enabled. Loops over positions do not pull the colors through the cache and compile to SIMD,
+// and the arrays are uploaded to OpenGL as they are. Point i is (x[i], y[i], z[i]), ring ordered like the vertices of
+// the loaders, invalid points are (0, 0, 0).
+class point_cloud {
+public:
+    static constexpr size_t alignment = 64;
+    template <typename T>
+    using aligned_vector = std::vector<T, aligned_allocator<T, alignment>>;
+
+    // one array of the cloud as an OpenGL vertex attribute source: count elements of component_count values
+    struct attribute_view {
+        const void* data = nullptr;
+        size_t count = 0;
+        int component_count = 1;
+        size_t stride = 0;
+
+        size_t get_byte_size() const { return count * stride; }
+    };
+
+    point_cloud() = default;
+    explicit point_cloud(size_t size);
+
+    // without keep_colors the cloud has only intensities, colors come from a colormap when they are needed
+    static point_cloud from_vertices(const std::vector<file_loader::vertex>& vertices, bool keep_colors = true);
+    // without colors the vertex color is the intensity, like the loaders give it
+    std::vector<file_loader::vertex> to_vertices() const;
+
+    size_t size() const { return m_x.size(); }
+    bool empty() const { return m_x.empty(); }
+    void resize(size_t size);
+    void clear();
+    void reserve(size_t capacity);
+    // the color is only stored if the colors are enabled
+    void push_back(const glm::vec3& position, uint16_t intensity, const glm::vec3& color = glm::vec3(0.0f));
+
+    glm::vec3 get_position(const size_t i) const { return {m_x[i], m_y[i], m_z[i]}; }
+    void set_position(const size_t i, const glm::vec3& position) {
+        m_x[i] = position.x;
+        m_y[i] = position.y;
+        m_z[i] = position.z;
+    }
+    bool is_valid(const size_t i) const { return m_x[i] != 0.0f || m_y[i] != 0.0f || m_z[i] != 0.0f; }
+    file_loader::vertex get_vertex(size_t i) const;
+    void set_vertex(size_t i, const file_loader::vertex& vertex);
+
+    const float* get_x() const { return m_x.data(); }
+    const float* get_y() const { return m_y.data(); }
+    const float* get_z() const { return m_z.data(); }
+    float* get_x() { return m_x.data(); }
+    float* get_y() { return m_y.data(); }
+    float* get_z() { return m_z.data(); }
+    const uint16_t* get_intensities() const { return m_intensities.data(); }
+    uint16_t* get_intensities() { return m_intensities.data(); }
+
+    // optional attributes, sized with the cloud once enabled
+    void enable_colors();
+    bool has_colors() const { return m_has_colors; }
+    const glm::vec3* get_colors() const { return m_colors.data(); }
+    glm::vec3* get_colors() { return m_colors.data(); }
+    void enable_normals();
+    bool has_normals() const { return m_has_normals; }
+    const glm::vec3* get_normals() const { return m_normals.data(); }
+    glm::vec3* get_normals() { return m_normals.data(); }
+    void enable_mask();
+    bool has_mask() const { return m_has_mask; }
+    const uint8_t* get_mask() const { return m_mask.data(); }
+    uint8_t* get_mask() { return m_mask.data(); }
+
+    attribute_view get_x_view() const { return {m_x.data(), m_x.size(), 1, sizeof(float)}; }
+    attribute_view get_y_view() const { return {m_y.data(), m_y.size(), 1, sizeof(float)}; }
+    attribute_view get_z_view() const { return {m_z.data(), m_z.size(), 1, sizeof(float)}; }
+    attribute_view get_color_view() const { return {m_colors.data(), m_colors.size(), 3, sizeof(glm::vec3)}; }
+    attribute_view get_normal_view() const { return {m_normals.data(), m_normals.size(), 3, sizeof(glm::vec3)}; }
+
+    size_t get_memory_size() const;
+
+private:
+    aligned_vector<float> m_x;
+    aligned_vector<float> m_y;
+    aligned_vector<float> m_z;
+    aligned_vector<uint16_t> m_intensities;
+    aligned_vector<glm::vec3> m_colors;
+    aligned_vector<glm::vec3> m_normals;
+    aligned_vector<uint8_t> m_mask;
+    bool m_has_colors = false;
+    bool m_has_normals = false;
+    bool m_has_mask = false;
+};
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cmath>
+#include "range_image.h"
+
+namespace {
+    constexpr float degrees_to_radians = 3.14159265358979f / 180.0f;
+
+    int get_quantized_azimuth(const glm::vec3& position) {
+        const int azimuth = (int)std::lround(std::atan2(position.y, position.x) / degrees_to_radians / range_image::azimuth_unit);
+        return (azimuth % range_image::azimuth_steps + range_image::azimuth_steps) % range_image::azimuth_steps;
+    }
+}
+
+range_image::range_image(const int beam_count, const size_t column_count) :
+    m_beam_count(beam_count),
+    m_column_count(column_count),
+    m_elevations(beam_count, 0.0f),
+    m_elevation_cos(beam_count, 1.0f),
+    m_elevation_sin(beam_count, 0.0f),
+    m_column_azimuths(column_count, 0),
+    m_column_cos(column_count, 1.0f),
+    m_column_sin(column_count, 0.0f),
+    m_ranges(beam_count * column_count, 0.0f),
+    m_intensities(beam_count * column_count, 0),
+    m_azimuth_offsets(beam_count * column_count, 0),
+    m_valid_mask((beam_count * column_count + 63) / 64, 0) {}
+
+range_image range_image::from_vertices(const std::vector<file_loader::vertex>& vertices, const int beam_count) {
+    const size_t column_count = vertices.size() / beam_count;
+    range_image image(beam_count, column_count);
+    auto is_valid_vertex = [&vertices](const size_t i) { return vertices[i].position != glm::vec3(0.0f); };
+
+    // one azimuth per column, taken from its first valid point, the cells store their difference to it.
+    // Empty columns continue the step of the previous ones.
+    int previous_azimuth = 0;
+    int previous_step = 0;
+    for (size_t column = 0; column < column_count; ++column) {
+        int column_azimuth = -1;
+        for (int ring = 0; ring < beam_count; ++ring) {
+            const size_t i = column * beam_count + ring;
+            const file_loader::vertex& vertex = vertices[i];
+            const uint8_t intensity = (uint8_t)std::clamp((int)std::lround(vertex.intensity), 0, 255);
+            if (!is_valid_vertex(i)) {
+                image.set_cell(ring, column, 0.0f, intensity);
+                continue;
+            }
+            const int azimuth = get_quantized_azimuth(vertex.position);
+            if (column_azimuth < 0) {
+                column_azimuth = azimuth;
+            }
+            const int offset = std::clamp(wrap_azimuth_difference(azimuth - column_azimuth), -max_azimuth_offset, max_azimuth_offset);
+            image.set_cell(ring, column, glm::length(vertex.position), intensity, (int8_t)offset);
+        }
+        if (column_azimuth < 0) {
+            column_azimuth = ((previous_azimuth + previous_step) % azimuth_steps + azimuth_steps) % azimuth_steps;
+        }
+        if (column > 0) {
+            previous_step = wrap_azimuth_difference(column_azimuth - previous_azimuth);
+        }
+        image.set_column_azimuth(column, column_azimuth);
+        previous_azimuth = column_azimuth;
+    }
+
+    // the elevation of a ring is fixed by the sensor, it is stored once as the mean over the frame
+    for (int ring = 0; ring < beam_count; ++ring) {
+        double sum = 0.0;
+        size_t count = 0;
+        for (size_t column = 0; column < column_count; ++column) {
+            const size_t i = column * beam_count + ring;
+            if (is_valid_vertex(i)) {
+                const glm::vec3& p = vertices[i].position;
+                sum += std::atan2((double)p.z, std::sqrt((double)p.x * p.x + (double)p.y * p.y));
+                ++count;
+            }
+        }
+        image.set_elevation(ring, count > 0 ? (float)(sum / count) : 0.0f);
+    }
+    return image;
+}
+
+int range_image::wrap_azimuth_difference(int difference) {
+    difference %= azimuth_steps;
+    if (difference >= azimuth_steps / 2) {
+        difference -= azimuth_steps;
+    } else if (difference < -azimuth_steps / 2) {
+        difference += azimuth_steps;
+    }
+    return difference;
+}
+
+void range_image::to_vertices(std::vector<file_loader::vertex>& vertices) const {
+    vertices.resize(get_cell_count());
+    std::vector<glm::vec3> positions(m_beam_count);
+    for (size_t column = 0; column < m_column_count; ++column) {
+        get_column_positions(column, positions.data());
+        for (int ring = 0; ring < m_beam_count; ++ring) {
+            file_loader::vertex& vertex = vertices[get_vertex_index(ring, column)];
+            vertex.position = positions[ring];
+            vertex.intensity = m_intensities[get_cell_index(ring, column)];
+            vertex.color = glm::vec3(vertex.intensity);
+        }
+    }
+}
+
+glm::vec3 range_image::get_position(const int ring, const size_t column) const {
+    const size_t cell = get_cell_index(ring, column);
+    if (!is_valid(cell)) {
+        return glm::vec3(0.0f);
+    }
+    float azimuth_cos = m_column_cos[column];
+    float azimuth_sin = m_column_sin[column];
+    if (m_azimuth_offsets[cell] != 0) {
+        const float cell_azimuth = (m_column_azimuths[column] + m_azimuth_offsets[cell]) * azimuth_unit * degrees_to_radians;
+        azimuth_cos = std::cos(cell_azimuth);
+        azimuth_sin = std::sin(cell_azimuth);
+    }
+    const float range = m_ranges[cell];
+    const float horizontal_range = range * m_elevation_cos[ring];
+    return glm::vec3(horizontal_range * azimuth_cos, horizontal_range * azimuth_sin, range * m_elevation_sin[ring]);
+}
+
+void range_image::get_column_positions(const size_t column, glm::vec3* positions) const {
+    for (int ring = 0; ring < m_beam_count; ++ring) {
+        positions[ring] = get_position(ring, column);
+    }
+}
+
+void range_image::set_cell(const int ring, const size_t column, const float range, const uint8_t intensity, const int8_t azimuth_offset) {
+    const size_t cell = get_cell_index(ring, column);
+    m_ranges[cell] = range;
+    m_intensities[cell] = intensity;
+    m_azimuth_offsets[cell] = azimuth_offset;
+    const uint64_t bit = uint64_t(1) << (cell & 63);
+    if (range > 0.0f) {
+        m_valid_mask[cell >> 6] |= bit;
+    } else {
+        m_valid_mask[cell >> 6] &= ~bit;
+    }
+}
+
+void range_image::invalidate(const int ring, const size_t column) {
+    const size_t cell = get_cell_index(ring, column);
+    m_ranges[cell] = 0.0f;
+    m_valid_mask[cell >> 6] &= ~(uint64_t(1) << (cell & 63));
+}
+
+void range_image::set_elevation(const int ring, const float elevation) {
+    m_elevations[ring] = elevation;
+    m_elevation_cos[ring] = std::cos(elevation);
+    m_elevation_sin[ring] = std::sin(elevation);
+}
+
+void range_image::set_column_azimuth(const size_t column, const int azimuth) {
+    m_column_azimuths[column] = azimuth;
+    m_column_cos[column] = std::cos(azimuth * azimuth_unit * degrees_to_radians);
+    m_column_sin[column] = std::sin(azimuth * azimuth_unit * degrees_to_radians);
+}
+
+size_t range_image::get_valid_count() const {
+    size_t count = 0;
+    for (const uint64_t word : m_valid_mask) {
+        uint64_t bits = word;
+        for (; bits != 0; bits &= bits - 1) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+size_t range_image::get_memory_size() const {
+    return m_elevations.size() * sizeof(float) * 3 + m_column_azimuths.size() * (sizeof(int) + sizeof(float) * 2) +
+        m_ranges.size() * sizeof(float) + m_intensities.size() + m_azimuth_offsets.size() + m_valid_mask.size() * sizeof(uint64_t);
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "file_loader.h"
+
+// a ring ordered lidar frame as a beam_count x column_count grid: a range, an intensity and a small azimuth offset per
+// cell, one elevation per ring and one azimuth per column with their sin / cos precomputed, and a validity bitmask.
+// 6 bytes and a bit per point instead of the 24 of a vertex, positions are computed only where they are needed.
+// Cells are stored ring by ring, so a scan line is contiguous; vertex indices stay column major like the loaders'.
+class range_image {
+public:
+    // the azimuths are quantized to 0.01 degrees like in the frame archive
+    static constexpr float azimuth_unit = 0.01f;
+    static constexpr int azimuth_steps = 36000;
+    static constexpr int max_azimuth_offset = 63;
+
+    range_image() = default;
+    range_image(int beam_count, size_t column_count);
+
+    // a column takes the azimuth of its first valid point, the elevation of a ring is its mean over the frame.
+    // The intensity is clamped to 0 - 255 as the recordings store it.
+    static range_image from_vertices(const std::vector<file_loader::vertex>& vertices, int beam_count = active_sensor_model::beam_count);
+    // invalid cells become (0, 0, 0) points, the color is the intensity
+    void to_vertices(std::vector<file_loader::vertex>& vertices) const;
+    // the shorter way around the circle, in [-azimuth_steps / 2, azimuth_steps / 2)
+    static int wrap_azimuth_difference(int difference);
+
+    int get_beam_count() const { return m_beam_count; }
+    size_t get_column_count() const { return m_column_count; }
+    size_t get_cell_count() const { return m_ranges.size(); }
+    size_t get_cell_index(const int ring, const size_t column) const { return ring * m_column_count + column; }
+    // the index of the cell in the column major vertex order of the loaders and the ring mesh
+    int get_vertex_index(const int ring, const size_t column) const { return (int)(column * m_beam_count + ring); }
+
+    bool is_valid(const size_t cell) const { return (m_valid_mask[cell >> 6] >> (cell & 63)) & 1; }
+    bool is_valid(const int ring, const size_t column) const { return is_valid(get_cell_index(ring, column)); }
+    float get_range(const int ring, const size_t column) const { return m_ranges[get_cell_index(ring, column)]; }
+    uint8_t get_intensity(const int ring, const size_t column) const { return m_intensities[get_cell_index(ring, column)]; }
+    int8_t get_azimuth_offset(const int ring, const size_t column) const { return m_azimuth_offsets[get_cell_index(ring, column)]; }
+    float get_elevation(const int ring) const { return m_elevations[ring]; }
+    int get_column_azimuth(const size_t column) const { return m_column_azimuths[column]; }
+    glm::vec3 get_position(int ring, size_t column) const;
+    // the positions of the beam_count cells of a column, (0, 0, 0) for the invalid ones
+    void get_column_positions(size_t column, glm::vec3* positions) const;
+
+    // a range of 0 marks the cell invalid
+    void set_cell(int ring, size_t column, float range, uint8_t intensity, int8_t azimuth_offset = 0);
+    void invalidate(int ring, size_t column);
+    void set_elevation(int ring, float elevation);
+    // in azimuth_unit steps, 0 - azimuth_steps
+    void set_column_azimuth(size_t column, int azimuth);
+
+    size_t get_valid_count() const;
+    size_t get_memory_size() const;
+
+private:
+    int m_beam_count = 0;
+    size_t m_column_count = 0;
+
+    std::vector<float> m_elevations;
+    std::vector<float> m_elevation_cos;
+    std::vector<float> m_elevation_sin;
+    std::vector<int> m_column_azimuths;
+    std::vector<float> m_column_cos;
+    std::vector<float> m_column_sin;
+
+    std::vector<float> m_ranges;
+    std::vector<uint8_t> m_intensities;
+    std::vector<int8_t> m_azimuth_offsets;
+    std::vector<uint64_t> m_valid_mask;
+};
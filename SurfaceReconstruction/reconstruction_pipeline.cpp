@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "reconstruction_pipeline.h"
+#include "camera_colorizer.h"
+
+reconstruction_pipeline::frame_statistics reconstruction_pipeline::process(frame& frame, const settings& settings, std::vector<int>& mesh_indices) {
+    if (frame.image.get_cell_count() > 0) {
+        return process_range_image(frame, settings, mesh_indices);
+    }
+
+    using clock = std::chrono::steady_clock;
+    frame_statistics statistics;
+    const auto crop_start = clock::now();
+    statistics.cropped_points = crop_sensor_rig(frame.vertices, settings.sensor_rig_boundary);
+    const auto colorize_start = clock::now();
+    statistics.shaded_points = camera_colorizer::colorize(frame.vertices, frame.camera_params, frame.images);
+    const auto mesh_start = clock::now();
+    build_ring_mesh(frame.vertices, (int)frame.vertices.size() - active_sensor_model::beam_count, settings, mesh_indices);
+    const auto mesh_end = clock::now();
+    statistics.triangles = mesh_indices.size() / 3;
+    statistics.crop_seconds = std::chrono::duration<double>(colorize_start - crop_start).count();
+    statistics.colorize_seconds = std::chrono::duration<double>(mesh_start - colorize_start).count();
+    statistics.mesh_seconds = std::chrono::duration<double>(mesh_end - mesh_start).count();
+    return statistics;
+}
+
+reconstruction_pipeline::frame_statistics reconstruction_pipeline::process_range_image(frame& frame, const settings& settings, std::vector<int>& mesh_indices) {
+    using clock = std::chrono::steady_clock;
+    frame_statistics statistics;
+    const auto crop_start = clock::now();
+    statistics.cropped_points = crop_sensor_rig(frame.image, settings.sensor_rig_boundary);
+    const auto colorize_start = clock::now();
+    // the points are only needed for the colors and the export, the mesh is built on the image
+    frame.image.to_vertices(frame.vertices);
+    file_loader::normalize_intensities(frame.vertices);
+    statistics.shaded_points = camera_colorizer::colorize(frame.vertices, frame.camera_params, frame.images);
+    const auto mesh_start = clock::now();
+    build_ring_mesh(frame.image, settings, mesh_indices);
+    const auto mesh_end = clock::now();
+    statistics.triangles = mesh_indices.size() / 3;
+    statistics.crop_seconds = std::chrono::duration<double>(colorize_start - crop_start).count();
+    statistics.colorize_seconds = std::chrono::duration<double>(mesh_start - colorize_start).count();
+    statistics.mesh_seconds = std::chrono::duration<double>(mesh_end - mesh_start).count();
+    return statistics;
+}
+
+size_t reconstruction_pipeline::crop_sensor_rig(std::vector<file_loader::vertex>& vertices, const octree::boundary& sensor_rig_boundary) {
+    size_t cropped_count = 0;
+    for (file_loader::vertex& vertex : vertices) {
+        if (vertex.position != glm::vec3(0, 0, 0) && sensor_rig_boundary.contains(vertex.position)) {
+            vertex.position = glm::vec3(0, 0, 0);
+            ++cropped_count;
+        }
+    }
+    return cropped_count;
+}
+
+size_t reconstruction_pipeline::crop_sensor_rig(range_image& image, const octree::boundary& sensor_rig_boundary) {
+    size_t cropped_count = 0;
+    for (int ring = 0; ring < image.get_beam_count(); ++ring) {
+        for (size_t column = 0; column < image.get_column_count(); ++column) {
+            if (image.is_valid(ring, column) && sensor_rig_boundary.contains(image.get_position(ring, column))) {
+                image.invalidate(ring, column);
+                ++cropped_count;
+            }
+        }
+    }
+    return cropped_count;
+}
+
+std::vector<file_loader::vertex> reconstruction_pipeline::filter_shaded_points(const std::vector<file_loader::vertex>& points,
+                                                                               const file_loader::digital_camera_params& camera_params,
+                                                                               const octree::boundary& sensor_rig_boundary) {
+    std::vector<file_loader::vertex> shaded_points;
+    const int camera_count = std::min((int)camera_params.devices.size(), 3);
+    for (const auto& point : points) {
+        bool is_shaded = false;
+        glm::vec2 uv;
+        for (int i = 0; i < camera_count && !is_shaded; ++i) {
+            is_shaded = camera_colorizer::project(camera_params, i, point.position, uv);
+        }
+        if (is_shaded && !sensor_rig_boundary.contains(point.position)) {
+            shaded_points.push_back(point);
+        }
+    }
+    return shaded_points;
+}
+
+void reconstruction_pipeline::build_ring_mesh(const std::vector<file_loader::vertex>& vertices, const int point_count, const settings& settings, std::vector<int>& indices) {
+    indices.clear();
+    // each column holds beam_count points in ring order, a quad spans two neighbouring rings of two neighbouring columns
+    constexpr int beams = active_sensor_model::beam_count;
+    const float cut_distance = settings.mesh_vertex_cut_distance;
+    const octree::boundary& rig = settings.sensor_rig_boundary;
+    for (int i = 0; i < point_count; ++i) {
+        if ((i % beams) != beams - 1 && i < point_count - beams) {
+            if (is_outside_of_sensor_rig_boundary(vertices, i, i + 1, i + beams + 1, rig) && is_mesh_vertex_cut_distance_ok(vertices, i, i + 1, i + beams + 1, cut_distance)) {
+                indices.push_back(i + 0);
+                indices.push_back(i + 1);
+                indices.push_back(i + beams + 1);
+            }
+            if (is_outside_of_sensor_rig_boundary(vertices, i, i + beams + 1, i + beams, rig) && is_mesh_vertex_cut_distance_ok(vertices, i, i + beams + 1, i + beams, cut_distance)) {
+                indices.push_back(i + 0);
+                indices.push_back(i + beams + 1);
+                indices.push_back(i + beams);
+            }
+        }
+    }
+}
+
+void reconstruction_pipeline::build_ring_mesh(const range_image& image, const settings& settings, std::vector<int>& indices) {
+    indices.clear();
+    const int beams = image.get_beam_count();
+    const float cut_distance = settings.mesh_vertex_cut_distance;
+    const octree::boundary& rig = settings.sensor_rig_boundary;
+    // positions of the current and the next column, a cell is usable if it is valid and outside of the rig
+    std::vector<glm::vec3> positions[2] = {std::vector<glm::vec3>(beams), std::vector<glm::vec3>(beams)};
+    std::vector<bool> is_usable[2] = {std::vector<bool>(beams), std::vector<bool>(beams)};
+    auto load_column = [&](const size_t column, const int slot) {
+        image.get_column_positions(column, positions[slot].data());
+        for (int ring = 0; ring < beams; ++ring) {
+            is_usable[slot][ring] = image.is_valid(ring, column) && !rig.contains(positions[slot][ring]);
+        }
+    };
+    auto is_triangle_ok = [&](const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) {
+        return glm::distance(p0, p1) < cut_distance && glm::distance(p1, p2) < cut_distance && glm::distance(p2, p0) < cut_distance;
+    };
+
+    if (image.get_column_count() > 0) {
+        load_column(0, 0);
+    }
+    // the quads of the last two columns are left out like process leaves them out of the vertex mesh
+    for (size_t column = 0; column + 2 < image.get_column_count(); ++column) {
+        const int current = column & 1;
+        const int next = current ^ 1;
+        load_column(column + 1, next);
+        const std::vector<glm::vec3>& p = positions[current];
+        const std::vector<glm::vec3>& q = positions[next];
+        for (int ring = 0; ring < beams - 1; ++ring) {
+            const int i = image.get_vertex_index(ring, column);
+            const bool is_diagonal_usable = is_usable[current][ring] && is_usable[next][ring + 1];
+            if (is_diagonal_usable && is_usable[current][ring + 1] && is_triangle_ok(p[ring], p[ring + 1], q[ring + 1])) {
+                indices.push_back(i + 0);
+                indices.push_back(i + 1);
+                indices.push_back(i + beams + 1);
+            }
+            if (is_diagonal_usable && is_usable[next][ring] && is_triangle_ok(p[ring], q[ring + 1], q[ring])) {
+                indices.push_back(i + 0);
+                indices.push_back(i + beams + 1);
+                indices.push_back(i + beams);
+            }
+        }
+    }
+}
+
+void reconstruction_pipeline::build_delaunay(const std::vector<file_loader::vertex>& points, const size_t max_point_count, delaunay_3d& delaunay) {
+    delaunay = delaunay_3d(200.0f, glm::vec3(0.0f, 0.0f, 120.0f));
+    for (size_t i = 0; i < std::min(points.size(), max_point_count); ++i) {
+        delaunay.insert_point(points[i]);
+    }
+    for (int i = 0; i < 4; ++i) {
+        delaunay.cleanup_super_tetrahedron();
+    }
+}
+
+size_t reconstruction_pipeline::crop_sensor_rig(point_cloud& points, const octree::boundary& sensor_rig_boundary) {
+    float* x = points.get_x();
+    float* y = points.get_y();
+    float* z = points.get_z();
+    const glm::vec3& tlf = sensor_rig_boundary.m_top_left_front;
+    const glm::vec3& brb = sensor_rig_boundary.m_bottom_right_back;
+    size_t cropped_count = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        const bool is_valid = x[i] != 0.0f || y[i] != 0.0f || z[i] != 0.0f;
+        const bool is_inside = x[i] >= tlf.x && x[i] <= brb.x && y[i] >= tlf.y && y[i] <= brb.y && z[i] >= tlf.z && z[i] <= brb.z;
+        const bool is_cropped = is_valid && is_inside;
+        x[i] = is_cropped ? 0.0f : x[i];
+        y[i] = is_cropped ? 0.0f : y[i];
+        z[i] = is_cropped ? 0.0f : z[i];
+        cropped_count += is_cropped;
+    }
+    return cropped_count;
+}
+
+point_cloud reconstruction_pipeline::filter_shaded_points(const point_cloud& points, const file_loader::digital_camera_params& camera_params,
+                                                          const octree::boundary& sensor_rig_boundary) {
+    point_cloud shaded_points;
+    if (points.has_colors()) {
+        shaded_points.enable_colors();
+    }
+    const int camera_count = std::min((int)camera_params.devices.size(), 3);
+    for (size_t i = 0; i < points.size(); ++i) {
+        const glm::vec3 position = points.get_position(i);
+        bool is_shaded = false;
+        glm::vec2 uv;
+        for (int camera = 0; camera < camera_count && !is_shaded; ++camera) {
+            is_shaded = camera_colorizer::project(camera_params, camera, position, uv);
+        }
+        if (is_shaded && !sensor_rig_boundary.contains(position)) {
+            shaded_points.push_back(position, points.get_intensities()[i], points.has_colors() ? points.get_colors()[i] : glm::vec3(0.0f));
+        }
+    }
+    return shaded_points;
+}
+
+void reconstruction_pipeline::build_ring_mesh(const point_cloud& points, const int point_count, const settings& settings, std::vector<int>& indices) {
+    indices.clear();
+    constexpr int beams = active_sensor_model::beam_count;
+    // the triangles of the quads below point_count reach up to point_count + 1
+    const int count = (int)std::min(points.size(), (size_t)std::max(point_count + 1, 0));
+    const float* x = points.get_x();
+    const float* y = points.get_y();
+    const float* z = points.get_z();
+    const float cut_distance = settings.mesh_vertex_cut_distance;
+    const glm::vec3& tlf = settings.sensor_rig_boundary.m_top_left_front;
+    const glm::vec3& brb = settings.sensor_rig_boundary.m_bottom_right_back;
+
+    // branch free passes over the coordinate arrays first: which points are outside of the rig, and which of the edges
+    // to the next ring (up), the next column (next) and the next ring of the next column (diagonal) are short enough
+    std::vector<uint8_t> is_outside(count);
+    std::vector<uint8_t> is_up_short(count, 0);
+    std::vector<uint8_t> is_next_short(count, 0);
+    std::vector<uint8_t> is_diagonal_short(count, 0);
+    for (int i = 0; i < count; ++i) {
+        is_outside[i] = !(x[i] >= tlf.x && x[i] <= brb.x && y[i] >= tlf.y && y[i] <= brb.y && z[i] >= tlf.z && z[i] <= brb.z);
+    }
+    auto mark_short_edges = [&](const int offset, uint8_t* is_short) {
+        for (int i = 0; i + offset < count; ++i) {
+            const float dx = x[i] - x[i + offset];
+            const float dy = y[i] - y[i + offset];
+            const float dz = z[i] - z[i + offset];
+            is_short[i] = std::sqrt(dx * dx + dy * dy + dz * dz) < cut_distance;
+        }
+    };
+    mark_short_edges(1, is_up_short.data());
+    mark_short_edges(beams, is_next_short.data());
+    mark_short_edges(beams + 1, is_diagonal_short.data());
+
+    // the quads start below point_count and one column before the last flagged point
+    const int quad_end = std::min(point_count, count - 1) - beams;
+    for (int i = 0; i < quad_end; ++i) {
+        if ((i % beams) == beams - 1) {
+            continue;
+        }
+        const bool is_diagonal_ok = is_outside[i] && is_outside[i + beams + 1] && is_diagonal_short[i];
+        if (is_diagonal_ok && is_outside[i + 1] && is_up_short[i] && is_next_short[i + 1]) {
+            indices.push_back(i + 0);
+            indices.push_back(i + 1);
+            indices.push_back(i + beams + 1);
+        }
+        if (is_diagonal_ok && is_outside[i + beams] && is_next_short[i] && is_up_short[i + beams]) {
+            indices.push_back(i + 0);
+            indices.push_back(i + beams + 1);
+            indices.push_back(i + beams);
+        }
+    }
+}
+
+linear_octree::build_statistics reconstruction_pipeline::build_octree(const point_cloud& points, const settings& settings, linear_octree& root,
+                                                                     const size_t thread_count, std::vector<uint32_t>* rejected_indices) {
+    linear_octree::build_statistics statistics;
+    root.build(points, settings.octree_leaf_capacity, settings.octree_max_depth, thread_count, &statistics, rejected_indices);
+    return statistics;
+}
+
+void reconstruction_pipeline::build_delaunay(const point_cloud& points, const size_t max_point_count, delaunay_3d& delaunay) {
+    delaunay = delaunay_3d(200.0f, glm::vec3(0.0f, 0.0f, 120.0f));
+    for (size_t i = 0; i < std::min(points.size(), max_point_count); ++i) {
+        delaunay.insert_point(points.get_position(i));
+    }
+    for (int i = 0; i < 4; ++i) {
+        delaunay.cleanup_super_tetrahedron();
+    }
+}
+
+bool reconstruction_pipeline::is_mesh_vertex_cut_distance_ok(const std::vector<file_loader::vertex>& vertices, const int i0, const int i1, const int i2, const float cut_distance) {
+    return glm::distance(vertices[i0].position, vertices[i1].position) < cut_distance &&
+        glm::distance(vertices[i1].position, vertices[i2].position) < cut_distance &&
+        glm::distance(vertices[i2].position, vertices[i0].position) < cut_distance;
+}
+
+bool reconstruction_pipeline::is_outside_of_sensor_rig_boundary(const std::vector<file_loader::vertex>& vertices, const int i0, const int i1, const int i2, const octree::boundary& sensor_rig_boundary) {
+    return !(sensor_rig_boundary.contains(vertices[i0].position) ||
+        sensor_rig_boundary.contains(vertices[i1].position) ||
+        sensor_rig_boundary.contains(vertices[i2].position));
+}
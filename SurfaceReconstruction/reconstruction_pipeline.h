@@ -0,0 +1,74 @@
+#pragma once
+#include <vector>
+#include "file_loader.h"
+#include "octree.h"
+#include "delaunay_3d.h"
+#include "dataset_manifest.h"
+#include "range_image.h"
+#include "point_cloud.h"
+#include "linear_octree.h"
+
+// the processing steps of the viewer without any SDL / OpenGL, so the application and the command line tool share
+// them: crop the sensor rig, color from the cameras, mesh the ring grid, octree and Delaunay of the points
+class reconstruction_pipeline {
+public:
+    struct settings {
+        octree::boundary sensor_rig_boundary = dataset_manifest::get_default_rig_boundary();
+        float mesh_vertex_cut_distance = 6.0f;
+        // an octree node is split while it holds more points and is above the depth
+        size_t octree_leaf_capacity = 8;
+        int octree_max_depth = linear_octree::max_level;
+    };
+
+    struct frame {
+        int frame_number = -1;
+        std::vector<file_loader::vertex> vertices;
+        // archive frames come as a range image, process then fills the vertices from it
+        range_image image;
+        std::vector<file_loader::image> images;
+        file_loader::digital_camera_params camera_params;
+    };
+
+    struct frame_statistics {
+        size_t cropped_points = 0;
+        size_t shaded_points = 0;
+        size_t triangles = 0;
+        double crop_seconds = 0.0;
+        double colorize_seconds = 0.0;
+        double mesh_seconds = 0.0;
+    };
+
+    // crop rig -> colorize -> mesh, the frame keeps its ring order so the mesh indices refer to frame.vertices. A frame
+    // with a range image is cropped and meshed on the image, its vertices get the intensity in 0 - 1 as their color.
+    static frame_statistics process(frame& frame, const settings& settings, std::vector<int>& mesh_indices);
+
+    // points inside the rig boundary (the car and the sensors) become invalid (0, 0, 0) points in place
+    static size_t crop_sensor_rig(std::vector<file_loader::vertex>& vertices, const octree::boundary& sensor_rig_boundary);
+    static size_t crop_sensor_rig(range_image& image, const octree::boundary& sensor_rig_boundary);
+    // the points at least one camera sees, without the rig
+    static std::vector<file_loader::vertex> filter_shaded_points(const std::vector<file_loader::vertex>& points,
+                                                                 const file_loader::digital_camera_params& camera_params,
+                                                                 const octree::boundary& sensor_rig_boundary);
+    // two triangles per quad of neighbouring rings and columns among the first point_count points
+    static void build_ring_mesh(const std::vector<file_loader::vertex>& vertices, int point_count, const settings& settings, std::vector<int>& indices);
+    // the mesh process builds from the vertices, from a range image: invalid cells are skipped and only two columns of
+    // positions are computed at a time. The indices refer to the vertices of range_image::to_vertices.
+    static void build_ring_mesh(const range_image& image, const settings& settings, std::vector<int>& indices);
+    static void build_delaunay(const std::vector<file_loader::vertex>& points, size_t max_point_count, delaunay_3d& delaunay);
+
+    // the same steps on a point_cloud, the loops only read the coordinate arrays
+    static size_t crop_sensor_rig(point_cloud& points, const octree::boundary& sensor_rig_boundary);
+    static point_cloud filter_shaded_points(const point_cloud& points, const file_loader::digital_camera_params& camera_params,
+                                            const octree::boundary& sensor_rig_boundary);
+    static void build_ring_mesh(const point_cloud& points, int point_count, const settings& settings, std::vector<int>& indices);
+    // bulk built from Morton codes, see linear_octree. The repeated and invalid points are counted, not inserted.
+    static linear_octree::build_statistics build_octree(const point_cloud& points, const settings& settings, linear_octree& root,
+                                                        size_t thread_count = 0, std::vector<uint32_t>* rejected_indices = nullptr);
+    static void build_delaunay(const point_cloud& points, size_t max_point_count, delaunay_3d& delaunay);
+
+    static bool is_mesh_vertex_cut_distance_ok(const std::vector<file_loader::vertex>& vertices, int i0, int i1, int i2, float cut_distance);
+    static bool is_outside_of_sensor_rig_boundary(const std::vector<file_loader::vertex>& vertices, int i0, int i1, int i2, const octree::boundary& sensor_rig_boundary);
+
+private:
+    static frame_statistics process_range_image(frame& frame, const settings& settings, std::vector<int>& mesh_indices);
+};
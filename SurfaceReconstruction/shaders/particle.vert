@@ -1,6 +1,9 @@
 #version 330
 
-in vec3 vs_in_pos;
+// the points are uploaded as separate x, y and z arrays
+in float vs_in_x;
+in float vs_in_y;
+in float vs_in_z;
 in vec3 vs_in_col;
 in vec2 vs_in_tex;
 
@@ -18,6 +21,7 @@ uniform float point_size;
 
 void main()
 {
+    vec3 vs_in_pos = vec3(vs_in_x, vs_in_y, vs_in_z);
     vs_out_col = vs_in_col;
     gl_PointSize = point_size;
     gl_Position = mvp * vec4(vs_in_pos, 1);
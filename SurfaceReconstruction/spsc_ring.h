@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// bounded lock-free queue for exactly one producer thread and one consumer thread. One slot stays empty to tell
+// a full ring from an empty one, so Capacity - 1 elements fit. Elements are moved in and out, so a ring of
+// frames hands over their buffers without copying.
+template <typename T, size_t Capacity>
+class spsc_ring {
+public:
+    static_assert(Capacity >= 2, "the ring needs at least two slots");
+
+    // producer side, fails and leaves value untouched when the ring is full
+    bool try_push(T& value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t next = (head + 1) % Capacity;
+        if (next == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        m_slots[head] = std::move(value);
+        m_head.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side
+    bool try_pop(T& value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(m_slots[tail]);
+        m_tail.store((tail + 1) % Capacity, std::memory_order_release);
+        return true;
+    }
+
+    bool is_empty() const {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> m_slots{};
+    // head and tail are written by different threads, keep them on separate cache lines
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+};
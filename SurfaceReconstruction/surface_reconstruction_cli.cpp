@@ -0,0 +1,151 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "batch_processor.h"
+#include "file_loader.h"
+#include "image_decoder.h"
+#include "mesh_exporter.h"
+
+// surface-reconstruction-cli: the processing of the viewer without a window or a GPU,
+// load -> crop rig -> colorize -> mesh -> export for every frame of the given inputs, frames in parallel
+
+namespace {
+    void print_usage() {
+        std::cout <<
+            "usage: surface-reconstruction-cli [options] <input>...\n"
+            "inputs: recording folders (dataset.json or fnNNN files), .xyz, .las, .srarc or VLP-16 .pcap files\n"
+            "  -o, --output <folder>       where the meshes are written (default: .)\n"
+            "  -f, --format <format>       ply, obj, glb or gltf (default: ply)\n"
+            "  -c, --cameras <file>        camera parameters (.json or .txt), overrides the dataset manifest\n"
+            "  -j, --threads <count>       worker threads (default: one per hardware thread)\n"
+            "  --in-flight <count>         frames loaded at the same time (default: twice the threads)\n"
+            "  --shard <index>/<count>     only every count-th frame starting at index, for splitting a run across machines\n"
+            "  --restart                   ignore the journal of an earlier run in the output folder\n"
+            "  --frame <number>            only the frame with this fnNNN number\n"
+            "  --rig <x0 y0 z0 x1 y1 z1>   sensor rig boundary (default: the manifest or the viewer default)\n"
+            "  --cut-distance <meters>     longest triangle edge of the mesh (default: 6)\n"
+            "  --shaded-points             also write the points the cameras see as .las\n"
+            "  --octree [<leaf>/<depth>]   build the octree of every frame and print its size, a node is split while it holds\n"
+            "                              more than leaf points and is above depth (default: 8/21, 21 at most)\n"
+            "  --delaunay <count>          tetrahedralize the first count shaded points of every frame\n";
+    }
+
+    bool parse_options(const int argc, char** argv, std::vector<std::string>& inputs, batch_processor::options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const auto next = [&](const int count) {
+                if (i + count >= argc) {
+                    std::cerr << "Missing value for " << arg << std::endl;
+                    return false;
+                }
+                return true;
+            };
+            try {
+                if (arg == "-h" || arg == "--help") {
+                    return false;
+                } else if (arg == "-o" || arg == "--output") {
+                    if (!next(1)) return false;
+                    options.output_folder = argv[++i];
+                } else if (arg == "-f" || arg == "--format") {
+                    if (!next(1)) return false;
+                    options.format = argv[++i];
+                } else if (arg == "-c" || arg == "--cameras") {
+                    if (!next(1)) return false;
+                    const std::string camera_params_file = argv[++i];
+                    options.camera_params = file_loader::has_extension(camera_params_file, ".json")
+                                                ? file_loader::load_digital_camera_params_json(camera_params_file)
+                                                : file_loader::load_digital_camera_params(camera_params_file);
+                    if (options.camera_params.devices.size() < 3) {
+                        std::cerr << "Could not load the three cameras from " << camera_params_file << std::endl;
+                        return false;
+                    }
+                } else if (arg == "-j" || arg == "--threads") {
+                    if (!next(1)) return false;
+                    options.thread_count = std::stoul(argv[++i]);
+                } else if (arg == "--in-flight") {
+                    if (!next(1)) return false;
+                    options.max_frames_in_flight = std::stoul(argv[++i]);
+                } else if (arg == "--shard") {
+                    if (!next(1)) return false;
+                    const std::string shard = argv[++i];
+                    const size_t separator = shard.find('/');
+                    options.shard_index = std::stoul(shard.substr(0, separator));
+                    options.shard_count = std::stoul(shard.substr(separator + 1));
+                    if (separator == std::string::npos || options.shard_count == 0 || options.shard_index >= options.shard_count) {
+                        std::cerr << "Invalid shard " << shard << ", expected <index>/<count>" << std::endl;
+                        return false;
+                    }
+                } else if (arg == "--restart") {
+                    options.resume = false;
+                } else if (arg == "--frame") {
+                    if (!next(1)) return false;
+                    options.frame_number = std::stoi(argv[++i]);
+                } else if (arg == "--rig") {
+                    if (!next(6)) return false;
+                    for (int axis = 0; axis < 3; ++axis) {
+                        options.settings.sensor_rig_boundary.m_top_left_front[axis] = std::stof(argv[++i]);
+                    }
+                    for (int axis = 0; axis < 3; ++axis) {
+                        options.settings.sensor_rig_boundary.m_bottom_right_back[axis] = std::stof(argv[++i]);
+                    }
+                    options.has_rig = true;
+                } else if (arg == "--cut-distance") {
+                    if (!next(1)) return false;
+                    options.settings.mesh_vertex_cut_distance = std::stof(argv[++i]);
+                } else if (arg == "--shaded-points") {
+                    options.export_shaded_points = true;
+                } else if (arg == "--octree") {
+                    options.build_octree = true;
+                    // the sizes are optional, an input does not look like <leaf>/<depth>
+                    const std::string sizes = i + 1 < argc ? argv[i + 1] : "";
+                    const size_t separator = sizes.find('/');
+                    if (separator != std::string::npos && sizes.find_first_not_of("0123456789/") == std::string::npos) {
+                        ++i;
+                        options.settings.octree_leaf_capacity = std::stoul(sizes.substr(0, separator));
+                        options.settings.octree_max_depth = std::stoi(sizes.substr(separator + 1));
+                        if (sizes.find('/', separator + 1) != std::string::npos || options.settings.octree_leaf_capacity == 0 ||
+                            options.settings.octree_max_depth > linear_octree::max_level) {
+                            std::cerr << "Invalid octree sizes " << sizes << ", expected <leaf capacity>/<max depth> with a depth up to "
+                                << linear_octree::max_level << std::endl;
+                            return false;
+                        }
+                    }
+                } else if (arg == "--delaunay") {
+                    if (!next(1)) return false;
+                    options.delaunay_point_count = std::stoi(argv[++i]);
+                } else if (!arg.empty() && arg[0] == '-') {
+                    std::cerr << "Unknown option " << arg << std::endl;
+                    return false;
+                } else {
+                    inputs.push_back(arg);
+                }
+            } catch (const std::exception&) {
+                std::cerr << "Invalid value for " << arg << std::endl;
+                return false;
+            }
+        }
+        if (!mesh_exporter::is_supported_file("mesh." + options.format)) {
+            std::cerr << "Unsupported mesh format: " << options.format << std::endl;
+            return false;
+        }
+        return !inputs.empty();
+    }
+}
+
+int main(const int argc, char** argv) {
+    std::vector<std::string> inputs;
+    batch_processor::options options;
+    if (!parse_options(argc, argv, inputs, options)) {
+        print_usage();
+        return 2;
+    }
+    if (!image_decoder::is_available()) {
+        std::cout << "Built without image decoding, meshes are colored by intensity" << std::endl;
+    }
+
+    batch_processor processor(options);
+    const batch_processor::report report = processor.run(inputs);
+    batch_processor::print_report(report);
+    return report.failed_frames == 0 ? 0 : 1;
+}
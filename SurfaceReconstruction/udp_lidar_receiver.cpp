@@ -0,0 +1,140 @@
+#include <iostream>
+#include <chrono>
+#include "udp_lidar_receiver.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+using socket_handle = SOCKET;
+static constexpr socket_handle invalid_socket = INVALID_SOCKET;
+static void close_socket(const socket_handle socket) { closesocket(socket); }
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+using socket_handle = int;
+static constexpr socket_handle invalid_socket = -1;
+static void close_socket(const socket_handle socket) { ::close(socket); }
+#endif
+
+static double get_time_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+udp_lidar_receiver::~udp_lidar_receiver() {
+    stop();
+}
+
+bool udp_lidar_receiver::start(const uint16_t port) {
+    stop();
+
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+        std::cerr << "Could not initialize winsock" << std::endl;
+        return false;
+    }
+#endif
+
+    const socket_handle udp_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (udp_socket == invalid_socket) {
+        std::cerr << "Could not create udp socket" << std::endl;
+        return false;
+    }
+
+    // a revolution is about 75 packets, a large receive buffer rides out hiccups of the decode thread
+    const int receive_buffer_size = 4 * 1024 * 1024;
+    setsockopt(udp_socket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&receive_buffer_size), sizeof(receive_buffer_size));
+    const int reuse_address = 1;
+    setsockopt(udp_socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse_address), sizeof(reuse_address));
+    // the timeout lets the receiver thread notice stop requests while no packets arrive
+#ifdef _WIN32
+    const DWORD timeout = 100;
+#else
+    const timeval timeout = {0, 100000};
+#endif
+    setsockopt(udp_socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(udp_socket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Could not bind udp port " << port << std::endl;
+        close_socket(udp_socket);
+        return false;
+    }
+
+    std::cout << "Listening for lidar packets on udp port " << port << std::endl;
+    m_packet_count = 0;
+    m_frame_count = 0;
+    m_dropped_frame_count = 0;
+    m_is_stop_requested = false;
+    m_receiver_thread = std::thread(&udp_lidar_receiver::receive_loop, this, (intptr_t)udp_socket);
+    return true;
+}
+
+void udp_lidar_receiver::stop() {
+    if (!m_receiver_thread.joinable()) {
+        return;
+    }
+    m_is_stop_requested = true;
+    m_receiver_thread.join();
+
+    frame frame;
+    while (m_frames.try_pop(frame)) {}
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool udp_lidar_receiver::poll_latest(frame& frame) {
+    bool has_frame = false;
+    udp_lidar_receiver::frame popped;
+    while (m_frames.try_pop(popped)) {
+        if (has_frame) {
+            m_dropped_frame_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (frame.vertices.capacity() > 0) {
+            frame.vertices.clear();
+            m_free_buffers.try_push(frame.vertices);
+        }
+        frame = std::move(popped);
+        has_frame = true;
+    }
+    return has_frame;
+}
+
+void udp_lidar_receiver::receive_loop(const intptr_t socket) {
+    const auto udp_socket = (socket_handle)socket;
+    velodyne_packet_decoder decoder;
+    frame revolution;
+    uint8_t packet[2048];
+
+    while (!m_is_stop_requested) {
+        const int size = recv(udp_socket, reinterpret_cast<char*>(packet), sizeof(packet), 0);
+        if (size <= 0 || !velodyne_packet_decoder::is_data_packet(packet, size)) {
+            continue;
+        }
+        m_packet_count.fetch_add(1, std::memory_order_relaxed);
+
+        decoder.decode(packet, get_time_seconds());
+        if (!decoder.has_frame()) {
+            continue;
+        }
+
+        // the decoder gets a consumed buffer back in exchange for the finished revolution
+        if (!m_free_buffers.try_pop(revolution.vertices)) {
+            revolution.vertices.clear();
+        }
+        decoder.take_frame(revolution);
+        m_frame_count.fetch_add(1, std::memory_order_relaxed);
+        if (!m_frames.try_push(revolution)) {
+            m_dropped_frame_count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    close_socket(udp_socket);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "spsc_ring.h"
+#include "velodyne_packet_decoder.h"
+
+// listens for live VLP-16 data packets on a local udp port. A receiver thread decodes them into revolutions and
+// hands finished frames to the render thread through a lock-free single producer / single consumer ring, the
+// consumed vertex buffers go back through a second ring so the receiver does not allocate per revolution
+class udp_lidar_receiver {
+public:
+    using frame = velodyne_packet_decoder::frame;
+    static constexpr size_t ring_capacity = 4;
+
+    udp_lidar_receiver() = default;
+    ~udp_lidar_receiver();
+
+    udp_lidar_receiver(const udp_lidar_receiver&) = delete;
+    udp_lidar_receiver& operator=(const udp_lidar_receiver&) = delete;
+
+    bool start(uint16_t port = velodyne_packet_decoder::data_port);
+    void stop();
+    bool is_running() const { return m_receiver_thread.joinable(); }
+
+    // render thread side, never blocks: moves out the newest finished revolution, older ones that were not
+    // picked up in time are skipped so the latency stays bounded by one revolution
+    bool poll_latest(frame& frame);
+
+    size_t get_packet_count() const { return m_packet_count.load(std::memory_order_relaxed); }
+    size_t get_frame_count() const { return m_frame_count.load(std::memory_order_relaxed); }
+    size_t get_dropped_frame_count() const { return m_dropped_frame_count.load(std::memory_order_relaxed); }
+
+private:
+    void receive_loop(intptr_t socket);
+
+    spsc_ring<frame, ring_capacity> m_frames;
+    spsc_ring<std::vector<file_loader::vertex>, ring_capacity> m_free_buffers;
+    std::thread m_receiver_thread;
+    std::atomic<bool> m_is_stop_requested{false};
+
+    std::atomic<size_t> m_packet_count{0};
+    std::atomic<size_t> m_frame_count{0};
+    std::atomic<size_t> m_dropped_frame_count{0};
+};
@@ -0,0 +1,136 @@
+#include <cmath>
+#include <cstring>
+#include "velodyne_packet_decoder.h"
+
+namespace {
+    constexpr uint16_t block_flag = 0xeeff;
+    constexpr size_t block_size = 100;
+    constexpr size_t return_mode_offset = 1204;
+    constexpr uint8_t dual_return_mode = 0x39;
+
+    // a column of 16 firings takes 55.296 us and the blocks are 110.592 us apart
+    constexpr float laser_firing_fraction = 2.304f / 110.592f;
+
+    uint16_t read_u16_le(const uint8_t* data) {
+        return (uint16_t)(data[0] | data[1] << 8);
+    }
+
+    // VLP-16 lasers fire interleaved: even ids from -15 degrees upwards, odd ids from +1 degree upwards
+    constexpr int get_laser_elevation(const int laser) {
+        return laser % 2 == 0 ? laser - 15 : laser;
+    }
+
+    constexpr int get_laser_ring(const int laser) {
+        return (get_laser_elevation(laser) + 15) / 2;
+    }
+}
+
+velodyne_packet_decoder::velodyne_packet_decoder() {
+    constexpr float degrees_to_radians = 3.14159265358979f / 180.0f;
+    for (int i = 0; i < azimuth_steps; ++i) {
+        m_azimuth_sin[i] = std::sin(i * 0.01f * degrees_to_radians);
+        m_azimuth_cos[i] = std::cos(i * 0.01f * degrees_to_radians);
+    }
+    for (int laser = 0; laser < laser_count; ++laser) {
+        m_laser_sin[laser] = std::sin(get_laser_elevation(laser) * degrees_to_radians);
+        m_laser_cos[laser] = std::cos(get_laser_elevation(laser) * degrees_to_radians);
+    }
+}
+
+bool velodyne_packet_decoder::is_data_packet(const uint8_t* payload, const size_t size) {
+    return size == data_packet_size && read_u16_le(payload) == block_flag;
+}
+
+void velodyne_packet_decoder::decode(const uint8_t* payload, const double timestamp) {
+    // in dual return mode every azimuth is sent twice, only the last return of each block pair is kept
+    const int block_step = payload[return_mode_offset] == dual_return_mode ? 2 : 1;
+
+    int last_gap = 0;
+    for (int block = 0; block < blocks_per_packet; block += block_step) {
+        const uint8_t* block_data = payload + block * block_size;
+        if (read_u16_le(block_data) != block_flag) {
+            continue;
+        }
+        const int azimuth = read_u16_le(block_data + 2) % azimuth_steps;
+
+        // the azimuth of the lasers is interpolated towards the next block of the packet
+        int gap = last_gap;
+        if (block + block_step < blocks_per_packet) {
+            const int next_azimuth = read_u16_le(block_data + block_step * block_size + 2) % azimuth_steps;
+            gap = (next_azimuth - azimuth + azimuth_steps) % azimuth_steps;
+        }
+        last_gap = gap;
+
+        const uint8_t* channel = block_data + 4;
+        for (int firing = 0; firing < firings_per_block; ++firing) {
+            const int column_azimuth = (azimuth + gap * firing / firings_per_block) % azimuth_steps;
+            // only a jump back of more than half a turn is a wrap, small steps back are azimuth jitter
+            if (m_last_azimuth >= 0 && column_azimuth + azimuth_steps / 2 < m_last_azimuth) {
+                finish_frame();
+            }
+            if (m_vertices.empty()) {
+                m_frame_timestamp = timestamp;
+            }
+            m_last_azimuth = column_azimuth;
+
+            const size_t column_start = m_vertices.size();
+            m_vertices.resize(column_start + laser_count);
+            file_loader::vertex* column = m_vertices.data() + column_start;
+            for (int laser = 0; laser < laser_count; ++laser, channel += 3) {
+                file_loader::vertex& vertex = column[get_laser_ring(laser)];
+                const uint16_t distance = read_u16_le(channel);
+                if (distance == 0) {
+                    vertex.position = glm::vec3(0.0f);
+                    vertex.color = glm::vec3(0.0f);
+                    vertex.intensity = 0.0f;
+                    continue;
+                }
+                const int laser_azimuth = (column_azimuth + (int)(gap * laser * laser_firing_fraction + 0.5f)) % azimuth_steps;
+                const float range = distance * distance_unit;
+                const float horizontal_range = range * m_laser_cos[laser];
+                vertex.position = glm::vec3(
+                    horizontal_range * m_azimuth_sin[laser_azimuth],
+                    horizontal_range * m_azimuth_cos[laser_azimuth],
+                    range * m_laser_sin[laser]);
+                vertex.intensity = channel[2];
+                vertex.color = glm::vec3(vertex.intensity);
+            }
+        }
+    }
+}
+
+void velodyne_packet_decoder::flush() {
+    finish_frame();
+}
+
+void velodyne_packet_decoder::reset() {
+    m_vertices.clear();
+    m_last_azimuth = -1;
+    m_frame_index = 0;
+    m_has_finished_frame = false;
+}
+
+bool velodyne_packet_decoder::take_frame(frame& frame) {
+    if (!m_has_finished_frame) {
+        return false;
+    }
+    frame.index = m_finished_frame.index;
+    frame.timestamp = m_finished_frame.timestamp;
+    frame.column_count = m_finished_frame.column_count;
+    std::swap(frame.vertices, m_finished_frame.vertices);
+    m_has_finished_frame = false;
+    return true;
+}
+
+void velodyne_packet_decoder::finish_frame() {
+    if (m_vertices.empty()) {
+        return;
+    }
+    // a finished frame nobody took yet is replaced, its buffer becomes the next frame's
+    m_finished_frame.index = m_frame_index++;
+    m_finished_frame.timestamp = m_frame_timestamp;
+    m_finished_frame.column_count = m_vertices.size() / laser_count;
+    std::swap(m_finished_frame.vertices, m_vertices);
+    m_vertices.clear();
+    m_has_finished_frame = true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "file_loader.h"
+
+// decodes VLP-16 data packets into ring ordered frames: every column holds the 16 lasers from the lowest to the
+// highest elevation, the same layout the xyz loaders produce, and a new frame starts whenever the azimuth wraps around
+class velodyne_packet_decoder {
+public:
+    static constexpr uint16_t data_port = 2368;
+    static constexpr size_t data_packet_size = 1206;
+    static constexpr int blocks_per_packet = 12;
+    static constexpr int firings_per_block = 2;
+    static constexpr int laser_count = vlp16_sensor::beam_count;
+    static constexpr int azimuth_steps = 36000;
+    static constexpr float distance_unit = 0.002f;
+
+    struct frame {
+        size_t index = 0;
+        double timestamp = 0.0;
+        size_t column_count = 0;
+        std::vector<file_loader::vertex> vertices;
+    };
+
+    velodyne_packet_decoder();
+
+    static bool is_data_packet(const uint8_t* payload, size_t size);
+
+    void decode(const uint8_t* payload, double timestamp);
+    // ends the current frame even though the azimuth did not wrap yet, e.g. at the end of a recording
+    void flush();
+    void reset();
+
+    bool has_frame() const { return m_has_finished_frame; }
+    // swaps the finished frame into frame, the vertex buffer frame held before is reused for a later frame
+    bool take_frame(frame& frame);
+
+private:
+    void finish_frame();
+
+    std::array<float, azimuth_steps> m_azimuth_sin;
+    std::array<float, azimuth_steps> m_azimuth_cos;
+    std::array<float, laser_count> m_laser_sin;
+    std::array<float, laser_count> m_laser_cos;
+
+    std::vector<file_loader::vertex> m_vertices;
+    double m_frame_timestamp = 0.0;
+    int m_last_azimuth = -1;
+    size_t m_frame_index = 0;
+    frame m_finished_frame;
+    bool m_has_finished_frame = false;
+};
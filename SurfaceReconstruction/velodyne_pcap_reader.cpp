@@ -0,0 +1,175 @@
+#include <iostream>
+#include <cstring>
+#include "velodyne_pcap_reader.h"
+
+namespace {
+    constexpr uint32_t pcap_magic_microseconds = 0xa1b2c3d4;
+    constexpr uint32_t pcap_magic_nanoseconds = 0xa1b23c4d;
+    constexpr size_t pcap_file_header_size = 24;
+    constexpr size_t pcap_record_header_size = 16;
+
+    constexpr uint32_t link_type_null = 0;
+    constexpr uint32_t link_type_ethernet = 1;
+    constexpr uint32_t link_type_raw = 101;
+    constexpr uint32_t link_type_linux_sll = 113;
+
+    uint16_t read_u16_be(const uint8_t* data) {
+        return (uint16_t)(data[0] << 8 | data[1]);
+    }
+
+    uint32_t read_u32(const uint8_t* data, const bool is_swapped) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        if (is_swapped) {
+            value = (value >> 24) | (value >> 8 & 0xff00) | (value << 8 & 0xff0000) | (value << 24);
+        }
+        return value;
+    }
+}
+
+bool velodyne_pcap_reader::open(const std::string& filename) {
+    close();
+    if (!m_file.open(filename)) {
+        std::cerr << "Could not open pcap file: " << filename << std::endl;
+        return false;
+    }
+    if (m_file.size() < pcap_file_header_size) {
+        std::cerr << "Not a pcap file: " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const uint8_t*>(m_file.data());
+    const uint32_t magic = read_u32(header, false);
+    const uint32_t swapped_magic = read_u32(header, true);
+    m_is_swapped = swapped_magic == pcap_magic_microseconds || swapped_magic == pcap_magic_nanoseconds;
+    if (magic != pcap_magic_microseconds && magic != pcap_magic_nanoseconds && !m_is_swapped) {
+        std::cerr << "Not a pcap file (pcapng is not supported): " << filename << std::endl;
+        close();
+        return false;
+    }
+    m_is_nanosecond = (m_is_swapped ? swapped_magic : magic) == pcap_magic_nanoseconds;
+    m_link_type = read_u32(header + 20, m_is_swapped) & 0xffff;
+    if (m_link_type != link_type_null && m_link_type != link_type_ethernet && m_link_type != link_type_raw && m_link_type != link_type_linux_sll) {
+        std::cerr << "Unsupported pcap link type " << m_link_type << " in " << filename << std::endl;
+        close();
+        return false;
+    }
+
+    rewind();
+    return true;
+}
+
+void velodyne_pcap_reader::close() {
+    m_file.close();
+    m_it = nullptr;
+    m_decoder.reset();
+}
+
+void velodyne_pcap_reader::rewind() {
+    m_it = m_file.data() + pcap_file_header_size;
+    m_decoder.reset();
+    m_packet_count = 0;
+    m_skipped_packet_count = 0;
+}
+
+bool velodyne_pcap_reader::read_frame(frame& frame) {
+    if (!is_open()) {
+        return false;
+    }
+    while (!m_decoder.has_frame()) {
+        const uint8_t* payload;
+        double timestamp;
+        if (!next_data_packet(payload, timestamp)) {
+            m_decoder.flush();
+            break;
+        }
+        m_decoder.decode(payload, timestamp);
+    }
+    return m_decoder.take_frame(frame);
+}
+
+bool velodyne_pcap_reader::next_data_packet(const uint8_t*& payload, double& timestamp) {
+    const char* end = m_file.end();
+    while ((size_t)(end - m_it) >= pcap_record_header_size) {
+        const auto* record = reinterpret_cast<const uint8_t*>(m_it);
+        const uint32_t seconds = read_u32(record, m_is_swapped);
+        const uint32_t fraction = read_u32(record + 4, m_is_swapped);
+        const uint32_t captured_size = read_u32(record + 8, m_is_swapped);
+        if ((size_t)(end - m_it) - pcap_record_header_size < captured_size) {
+            std::cerr << "Truncated pcap record after " << m_packet_count << " packets" << std::endl;
+            m_it = end;
+            return false;
+        }
+        m_it += pcap_record_header_size + captured_size;
+
+        size_t payload_size;
+        payload = get_udp_payload(record + pcap_record_header_size, captured_size, payload_size);
+        if (payload == nullptr) {
+            continue;
+        }
+        if (!velodyne_packet_decoder::is_data_packet(payload, payload_size)) {
+            // position packets and traffic of other devices on the data port
+            ++m_skipped_packet_count;
+            continue;
+        }
+        timestamp = seconds + fraction * (m_is_nanosecond ? 1e-9 : 1e-6);
+        ++m_packet_count;
+        return true;
+    }
+    m_it = end;
+    return false;
+}
+
+const uint8_t* velodyne_pcap_reader::get_udp_payload(const uint8_t* data, size_t size, size_t& payload_size) const {
+    // strip the link layer
+    if (m_link_type == link_type_ethernet) {
+        if (size < 14) {
+            return nullptr;
+        }
+        uint16_t ether_type = read_u16_be(data + 12);
+        size_t header_size = 14;
+        while (ether_type == 0x8100 && size >= header_size + 4) {
+            ether_type = read_u16_be(data + header_size + 2);
+            header_size += 4;
+        }
+        if (ether_type != 0x0800) {
+            return nullptr;
+        }
+        data += header_size;
+        size -= header_size;
+    } else if (m_link_type == link_type_linux_sll) {
+        if (size < 16 || read_u16_be(data + 14) != 0x0800) {
+            return nullptr;
+        }
+        data += 16;
+        size -= 16;
+    } else if (m_link_type == link_type_null) {
+        if (size < 4) {
+            return nullptr;
+        }
+        data += 4;
+        size -= 4;
+    }
+
+    // ipv4, only unfragmented udp datagrams to the data port are of interest
+    if (size < 20 || data[0] >> 4 != 4 || data[9] != 17) {
+        return nullptr;
+    }
+    const size_t ip_header_size = (data[0] & 0x0f) * 4;
+    if ((read_u16_be(data + 6) & 0x3fff) != 0 || size < ip_header_size + 8) {
+        return nullptr;
+    }
+    data += ip_header_size;
+    size -= ip_header_size;
+
+    if (read_u16_be(data + 2) != velodyne_packet_decoder::data_port) {
+        return nullptr;
+    }
+    const size_t udp_size = read_u16_be(data + 4);
+    if (udp_size < 8 || udp_size > size) {
+        return nullptr;
+    }
+    payload_size = udp_size - 8;
+    return data + 8;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "mapped_file.h"
+#include "velodyne_packet_decoder.h"
+
+// streams the VLP-16 data packets of a pcap recording through a velodyne_packet_decoder,
+// one ring ordered frame per revolution
+class velodyne_pcap_reader {
+public:
+    using frame = velodyne_packet_decoder::frame;
+
+    bool open(const std::string& filename);
+    void close();
+    bool is_open() const { return m_file.is_open(); }
+
+    // decodes packets until the azimuth wraps, the last (partial) frame of the recording is returned as well
+    bool read_frame(frame& frame);
+    // starts again from the first packet, used when a replay loops
+    void rewind();
+
+    size_t get_packet_count() const { return m_packet_count; }
+    size_t get_skipped_packet_count() const { return m_skipped_packet_count; }
+
+private:
+    bool next_data_packet(const uint8_t*& payload, double& timestamp);
+    const uint8_t* get_udp_payload(const uint8_t* data, size_t size, size_t& payload_size) const;
+
+    mapped_file m_file;
+    const char* m_it = nullptr;
+    bool m_is_swapped = false;
+    bool m_is_nanosecond = false;
+    uint32_t m_link_type = 0;
+
+    velodyne_packet_decoder m_decoder;
+
+    size_t m_packet_count = 0;
+    size_t m_skipped_packet_count = 0;
+};
@@ -0,0 +1,425 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <tuple>
+#include <random>
+#include <vector>
+#include "linear_octree.h"
+
+// linear-octree-test: builds the octree of random clouds and checks the node layout against the points, and the knn and
+// radius queries against a brute force scan of the cloud
+
+namespace {
+    int failure_count = 0;
+
+    void check(const bool condition, const char* description) {
+        // the checks run per node and point, the first failures are enough to go on
+        if (!condition && ++failure_count <= 20) {
+            std::cerr << "FAILED: " << description << std::endl;
+        }
+    }
+
+    // a uniform box with a dense cluster and repeated points, every tenth point is an invalid (0, 0, 0) one
+    point_cloud make_cloud(const size_t count, const unsigned seed) {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> box(-50.0f, 50.0f);
+        std::normal_distribution<float> cluster(10.0f, 0.05f);
+        point_cloud points;
+        for (size_t i = 0; i < count; ++i) {
+            if (i % 10 == 9) {
+                points.push_back(glm::vec3(0.0f), 0);
+            } else if (i % 10 == 8) {
+                points.push_back(glm::vec3(cluster(generator), cluster(generator), cluster(generator)), 0);
+            } else if (i % 10 == 7 && i > 100) {
+                points.push_back(points.get_position(i - 100), 0);
+            } else {
+                points.push_back(glm::vec3(box(generator), box(generator), box(generator)), 0);
+            }
+        }
+        return points;
+    }
+
+    // the points the tree keeps: the valid ones, of a repeated position only the one with the lowest index
+    std::vector<uint8_t> get_kept_points(const point_cloud& points) {
+        std::vector<uint8_t> is_kept(points.size(), 0);
+        std::map<std::tuple<float, float, float>, size_t> first_indices;
+        for (size_t i = 0; i < points.size(); ++i) {
+            const glm::vec3 position = points.get_position(i);
+            is_kept[i] = points.is_valid(i) && first_indices.emplace(std::make_tuple(position.x, position.y, position.z), i).second;
+        }
+        return is_kept;
+    }
+
+    bool is_inside(const octree::boundary& boundary, const glm::vec3& point) {
+        // the cell bounds are computed in float, allow for their rounding
+        const glm::vec3 tolerance = (boundary.m_bottom_right_back - boundary.m_top_left_front) * 1e-4f + glm::vec3(1e-4f);
+        return octree::boundary{boundary.m_top_left_front - tolerance, boundary.m_bottom_right_back + tolerance}.contains(point);
+    }
+
+    void test_build(const point_cloud& points, const size_t leaf_capacity, const int max_depth, const size_t thread_count) {
+        linear_octree tree;
+        linear_octree::build_statistics statistics;
+        std::vector<uint32_t> rejected_indices;
+        tree.build(points, leaf_capacity, max_depth, thread_count, &statistics, &rejected_indices);
+        const auto& nodes = tree.get_nodes();
+        const auto& indices = tree.get_point_indices();
+
+        // every kept point exactly once, the invalid and repeated ones left out and reported in increasing order
+        const std::vector<uint8_t> is_kept = get_kept_points(points);
+        std::vector<int> seen(points.size(), 0);
+        for (const uint32_t index : indices) {
+            check(index < points.size() && is_kept[index], "only kept points are in the tree");
+            ++seen[index];
+        }
+        std::vector<uint32_t> expected_rejected_indices;
+        size_t kept_count = 0;
+        size_t skipped_count = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            kept_count += is_kept[i];
+            skipped_count += !points.is_valid(i);
+            if (!is_kept[i]) {
+                expected_rejected_indices.push_back((uint32_t)i);
+            }
+            check(seen[i] == is_kept[i], "every kept point is in the tree once");
+        }
+        check(rejected_indices == expected_rejected_indices, "the rejected indices are the invalid and repeated points");
+        check(statistics.points == kept_count && statistics.skipped_points == skipped_count &&
+              statistics.duplicate_points == points.size() - kept_count - skipped_count && statistics.nodes == nodes.size(),
+              "build statistics match the tree");
+
+        const linear_octree::node& root = tree.get_root();
+        check(root.level == 0 && root.code == 0 && root.point_begin == 0 && root.point_end == indices.size(), "the root holds all points");
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            const linear_octree::node& node = nodes[i];
+            const octree::boundary boundary = tree.get_node_boundary(node);
+            for (uint32_t p = node.point_begin; p < node.point_end; ++p) {
+                check(is_inside(boundary, points.get_position(indices[p])), "the points of a node are inside its box");
+            }
+            if (node.is_leaf()) {
+                // a fuller leaf above max_depth is only left when its points share one cell of the finest level
+                const glm::vec3 finest_cell_size = (tree.get_boundary().m_bottom_right_back - tree.get_boundary().m_top_left_front) /
+                    (float)(1u << linear_octree::max_level);
+                bool is_single_cell = true;
+                for (uint32_t p = node.point_begin + 1; p < node.point_end; ++p) {
+                    const glm::vec3 difference = points.get_position(indices[p]) - points.get_position(indices[node.point_begin]);
+                    for (int axis = 0; axis < 3; ++axis) {
+                        is_single_cell &= std::abs(difference[axis]) <= finest_cell_size[axis] * 1.01f;
+                    }
+                }
+                check(node.get_point_count() > 0, "leaves are not empty");
+                check(node.get_point_count() <= leaf_capacity || node.level == tree.get_max_depth() || is_single_cell,
+                      "leaves hold at most leaf_capacity points");
+                continue;
+            }
+            // the children are contiguous, in octant order, one per bit of the mask, and split the points of the parent
+            check(node.get_point_count() > leaf_capacity && node.level < tree.get_max_depth(), "only nodes over leaf_capacity and above max_depth are split");
+            check(node.first_child > i && node.first_child + node.get_child_count() <= nodes.size(), "children follow their parent");
+            uint32_t point_begin = node.point_begin;
+            int child = node.first_child;
+            for (uint64_t octant = 0; octant < 8; ++octant) {
+                if (!(node.child_mask & 1 << octant)) {
+                    continue;
+                }
+                const linear_octree::node& child_node = nodes[child++];
+                check(child_node.code == (node.code << 3 | octant) && child_node.level == node.level + 1, "child codes extend the parent code");
+                check(child_node.point_begin == point_begin && child_node.point_end > child_node.point_begin, "children split the parent points");
+                point_begin = child_node.point_end;
+            }
+            check(point_begin == node.point_end, "children cover the parent points");
+        }
+    }
+
+    void test_thread_count_independence(const point_cloud& points) {
+        linear_octree single;
+        linear_octree parallel;
+        single.build(points, 8, linear_octree::max_level, 1);
+        parallel.build(points, 8, linear_octree::max_level, 4);
+        bool is_identical = single.get_point_indices() == parallel.get_point_indices() && single.get_nodes().size() == parallel.get_nodes().size();
+        for (size_t i = 0; is_identical && i < single.get_nodes().size(); ++i) {
+            const linear_octree::node& a = single.get_nodes()[i];
+            const linear_octree::node& b = parallel.get_nodes()[i];
+            is_identical = a.code == b.code && a.first_child == b.first_child && a.point_begin == b.point_begin &&
+                a.point_end == b.point_end && a.child_mask == b.child_mask && a.level == b.level;
+        }
+        check(is_identical, "the tree does not depend on the thread count");
+    }
+
+    float get_squared_distance(const glm::vec3& a, const glm::vec3& b) {
+        const float dx = b.x - a.x;
+        const float dy = b.y - a.y;
+        const float dz = b.z - a.z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // the squared distances of all kept points to the query, closest first
+    std::vector<linear_octree::neighbor> get_brute_force_neighbors(const point_cloud& points, const std::vector<uint8_t>& is_kept, const glm::vec3& query) {
+        std::vector<linear_octree::neighbor> neighbors;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (is_kept[i]) {
+                neighbors.push_back({(uint32_t)i, get_squared_distance(points.get_position(i), query)});
+            }
+        }
+        std::sort(neighbors.begin(), neighbors.end(), [](const linear_octree::neighbor& a, const linear_octree::neighbor& b) {
+            return a.squared_distance < b.squared_distance || (a.squared_distance == b.squared_distance && a.index < b.index);
+        });
+        return neighbors;
+    }
+
+    // points of the cloud, points next to them and points in the empty space around the bounds
+    std::vector<glm::vec3> make_queries(const point_cloud& points, const size_t count, const unsigned seed) {
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<size_t> index(0, points.size() - 1);
+        std::uniform_real_distribution<float> far_away(-80.0f, 80.0f);
+        std::normal_distribution<float> offset(0.0f, 0.5f);
+        std::vector<glm::vec3> queries;
+        while (queries.size() < count) {
+            const size_t i = index(generator);
+            if (!points.is_valid(i)) {
+                continue;
+            }
+            switch (queries.size() % 3) {
+            case 0: queries.push_back(points.get_position(i)); break;
+            case 1: queries.push_back(points.get_position(i) + glm::vec3(offset(generator), offset(generator), offset(generator))); break;
+            default: queries.push_back(glm::vec3(far_away(generator), far_away(generator), far_away(generator)) * 2.0f); break;
+            }
+        }
+        return queries;
+    }
+
+    // ties at the k-th distance may be broken either way, so the distances are compared and the indices have to be
+    // points at those distances
+    bool is_knn_result(const point_cloud& points, const glm::vec3& query, const std::vector<linear_octree::neighbor>& neighbors,
+                       const std::vector<linear_octree::neighbor>& expected, const size_t k) {
+        if (neighbors.size() != std::min(k, expected.size())) {
+            return false;
+        }
+        std::vector<uint32_t> indices;
+        for (size_t i = 0; i < neighbors.size(); ++i) {
+            if (neighbors[i].squared_distance != expected[i].squared_distance ||
+                get_squared_distance(points.get_position(neighbors[i].index), query) != neighbors[i].squared_distance) {
+                return false;
+            }
+            indices.push_back(neighbors[i].index);
+        }
+        std::sort(indices.begin(), indices.end());
+        return std::adjacent_find(indices.begin(), indices.end()) == indices.end();
+    }
+
+    bool is_radius_result(std::vector<linear_octree::neighbor> neighbors, const std::vector<linear_octree::neighbor>& expected, const float search_radius) {
+        std::vector<uint32_t> indices;
+        for (const linear_octree::neighbor& neighbor : neighbors) {
+            indices.push_back(neighbor.index);
+        }
+        std::vector<uint32_t> expected_indices;
+        for (const linear_octree::neighbor& neighbor : expected) {
+            if (neighbor.squared_distance <= search_radius * search_radius) {
+                expected_indices.push_back(neighbor.index);
+            }
+        }
+        std::sort(indices.begin(), indices.end());
+        std::sort(expected_indices.begin(), expected_indices.end());
+        return indices == expected_indices;
+    }
+
+    void test_queries(const point_cloud& points, const size_t leaf_capacity) {
+        linear_octree tree;
+        tree.build(points, leaf_capacity, linear_octree::max_level, 1);
+        const std::vector<glm::vec3> queries = make_queries(points, 150, 3);
+        const std::vector<uint8_t> is_kept = get_kept_points(points);
+        std::vector<linear_octree::neighbor> neighbors;
+        for (const glm::vec3& query : queries) {
+            const std::vector<linear_octree::neighbor> expected = get_brute_force_neighbors(points, is_kept, query);
+            for (const size_t k : {size_t(1), size_t(8), size_t(50)}) {
+                tree.knn(query, k, neighbors);
+                check(is_knn_result(points, query, neighbors, expected, k), "knn finds the k closest points");
+            }
+            for (const float search_radius : {0.1f, 1.0f, 5.0f}) {
+                tree.radius(query, search_radius, neighbors);
+                check(is_radius_result(neighbors, expected, search_radius), "radius finds the points within the radius");
+            }
+        }
+
+        tree.knn(queries.front(), 0, neighbors);
+        check(neighbors.empty(), "knn with k = 0 finds nothing");
+        tree.knn(queries.front(), points.size() + 10, neighbors);
+        check(is_knn_result(points, queries.front(), neighbors, get_brute_force_neighbors(points, is_kept, queries.front()), points.size() + 10),
+              "knn with k over the point count returns every kept point");
+    }
+
+    // the batched queries have to give the single query results in query order, whatever the thread count
+    void test_batched_queries(const point_cloud& points) {
+        linear_octree tree;
+        tree.build(points, 8, linear_octree::max_level, 1);
+        point_cloud queries;
+        for (const glm::vec3& query : make_queries(points, 5000, 4)) {
+            queries.push_back(query, 0);
+        }
+        queries.push_back(glm::vec3(0.0f), 0);
+
+        const auto is_batch_result = [&](const linear_octree::neighbor_lists& lists, const auto& single_query) {
+            if (lists.size() != queries.size() || lists.get_count(queries.size() - 1) != 0) {
+                return false;
+            }
+            std::vector<linear_octree::neighbor> neighbors;
+            for (size_t i = 0; i + 1 < queries.size(); ++i) {
+                single_query(queries.get_position(i), neighbors);
+                if (lists.get_count(i) != neighbors.size() ||
+                    !std::equal(neighbors.begin(), neighbors.end(), lists.get_neighbors(i), [](const linear_octree::neighbor& a, const linear_octree::neighbor& b) {
+                        return a.index == b.index && a.squared_distance == b.squared_distance;
+                    })) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        for (const size_t thread_count : {size_t(1), size_t(4)}) {
+            linear_octree::neighbor_lists lists;
+            tree.knn(queries, 8, lists, thread_count);
+            check(is_batch_result(lists, [&](const glm::vec3& query, std::vector<linear_octree::neighbor>& neighbors) { tree.knn(query, 8, neighbors); }),
+                  "batched knn matches the single queries");
+            tree.radius(queries, 1.0f, lists, thread_count);
+            check(is_batch_result(lists, [&](const glm::vec3& query, std::vector<linear_octree::neighbor>& neighbors) { tree.radius(query, 1.0f, neighbors); }),
+                  "batched radius matches the single queries");
+        }
+    }
+
+    // points within a millimeter of each other in a 100 m box are split down to about level 18, the cap keeps the tree shallow
+    void test_max_depth() {
+        std::mt19937 generator(5);
+        std::uniform_real_distribution<float> jitter(-1e-3f, 1e-3f);
+        point_cloud points;
+        points.push_back(glm::vec3(-50.0f), 0);
+        points.push_back(glm::vec3(50.0f), 0);
+        for (int i = 0; i < 2000; ++i) {
+            points.push_back(glm::vec3(10.0f + jitter(generator), 10.0f + jitter(generator), 10.0f + jitter(generator)), 0);
+        }
+
+        const auto get_depth = [](const linear_octree& tree) {
+            int depth = 0;
+            for (const linear_octree::node& node : tree.get_nodes()) {
+                depth = std::max(depth, (int)node.level);
+            }
+            return depth;
+        };
+        linear_octree tree;
+        tree.build(points, 8, linear_octree::max_level, 1);
+        check(get_depth(tree) > 6, "near duplicate points are split deeper than the cap under test");
+        for (const int max_depth : {0, 1, 6}) {
+            tree.build(points, 8, max_depth, 1);
+            check(tree.get_max_depth() == max_depth && get_depth(tree) == max_depth, "the tree stops at max_depth");
+            bool has_full_leaf = false;
+            for (const linear_octree::node& node : tree.get_nodes()) {
+                has_full_leaf |= node.is_leaf() && node.level == max_depth && node.get_point_count() > 8;
+            }
+            check(has_full_leaf, "a leaf at max_depth keeps more than leaf_capacity points");
+            test_build(points, 8, max_depth, 1);
+        }
+        tree.build(points, 8, linear_octree::max_level + 5, 1);
+        check(tree.get_max_depth() == linear_octree::max_level, "max_depth is clamped to max_level");
+    }
+
+    // repeats of a few points, points one float step apart that share their cell but are not repeats, and invalid points.
+    // The rejected points are found by comparing every point with all points before it.
+    void test_duplicates() {
+        std::mt19937 generator(6);
+        std::uniform_real_distribution<float> box(-20.0f, 20.0f);
+        std::uniform_int_distribution<int> kind(0, 5);
+        point_cloud points;
+        for (int i = 0; i < 3000; ++i) {
+            const int point_kind = i < 10 ? 5 : kind(generator);
+            if (point_kind == 0) {
+                points.push_back(glm::vec3(0.0f), 0);
+            } else if (point_kind == 1) {
+                points.push_back(glm::vec3(1.0f, 2.0f, 3.0f), 0);
+            } else if (point_kind == 2) {
+                points.push_back(points.get_position(std::uniform_int_distribution<int>(0, i - 1)(generator)), 0);
+            } else if (point_kind == 3) {
+                const glm::vec3 position = points.get_position(std::uniform_int_distribution<int>(0, i - 1)(generator));
+                points.push_back(glm::vec3(std::nextafter(position.x, 100.0f), position.y, position.z), 0);
+            } else {
+                points.push_back(glm::vec3(box(generator), box(generator), box(generator)), 0);
+            }
+        }
+
+        std::vector<uint32_t> expected_rejected_indices;
+        size_t skipped_count = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            bool is_repeat = false;
+            for (size_t j = 0; j < i && !is_repeat; ++j) {
+                is_repeat = points.is_valid(j) && points.get_position(j) == points.get_position(i);
+            }
+            skipped_count += !points.is_valid(i);
+            if (!points.is_valid(i) || is_repeat) {
+                expected_rejected_indices.push_back((uint32_t)i);
+            }
+        }
+
+        for (const size_t thread_count : {size_t(1), size_t(4)}) {
+            linear_octree tree;
+            linear_octree::build_statistics statistics;
+            std::vector<uint32_t> rejected_indices = {12345};
+            tree.build(points, 8, linear_octree::max_level, thread_count, &statistics, &rejected_indices);
+            check(rejected_indices.front() == 12345 &&
+                  std::equal(rejected_indices.begin() + 1, rejected_indices.end(), expected_rejected_indices.begin(), expected_rejected_indices.end()),
+                  "the rejected indices are appended and match the brute force ones");
+            check(statistics.skipped_points == skipped_count && statistics.duplicate_points == expected_rejected_indices.size() - skipped_count &&
+                  statistics.points + expected_rejected_indices.size() == points.size(),
+                  "the duplicate and skipped counts match the brute force ones");
+            check(statistics.duplicate_points > 500, "the cloud has many repeated points");
+        }
+        test_build(points, 8, linear_octree::max_level, 1);
+        test_build(points, 1, linear_octree::max_level, 1);
+    }
+
+    void test_degenerate_clouds() {
+        linear_octree tree;
+        tree.build(point_cloud(), 8, linear_octree::max_level, 1);
+        check(tree.empty(), "an empty cloud gives an empty tree");
+
+        point_cloud invalid;
+        invalid.push_back(glm::vec3(0.0f), 0);
+        tree.build(invalid, 8, linear_octree::max_level, 1);
+        check(tree.empty(), "a cloud of invalid points gives an empty tree");
+        std::vector<linear_octree::neighbor> neighbors(1);
+        tree.knn(glm::vec3(1.0f), 8, neighbors);
+        check(neighbors.empty(), "knn on an empty tree finds nothing");
+        neighbors.resize(1);
+        tree.radius(glm::vec3(1.0f), 10.0f, neighbors);
+        check(neighbors.empty(), "radius on an empty tree finds nothing");
+
+        // all points on a plane, the flat axis has no extent
+        point_cloud plane;
+        for (int i = 0; i < 1000; ++i) {
+            plane.push_back(glm::vec3((float)(i % 40) + 1.0f, (float)(i / 40) + 1.0f, 2.0f), 0);
+        }
+        test_build(plane, 8, linear_octree::max_level, 1);
+        test_queries(plane, 8);
+    }
+}
+
+int main() {
+    const point_cloud small = make_cloud(5000, 1);
+    // over the point count where the build starts its threads
+    const point_cloud large = make_cloud(100000, 2);
+
+    test_build(small, 8, linear_octree::max_level, 1);
+    test_build(small, 1, linear_octree::max_level, 1);
+    test_build(small, 64, linear_octree::max_level, 1);
+    test_build(large, 8, linear_octree::max_level, 4);
+    test_max_depth();
+    test_duplicates();
+    test_thread_count_independence(large);
+    test_queries(small, 8);
+    test_queries(small, 1);
+    test_queries(large, 8);
+    test_batched_queries(large);
+    test_degenerate_clouds();
+
+    if (failure_count > 0) {
+        std::cerr << failure_count << " checks failed" << std::endl;
+        return 1;
+    }
+    std::cout << "all linear_octree checks passed" << std::endl;
+    return 0;
+}